@@ -21,9 +21,9 @@ void Jsonify::JsonSerde::serialize(JsonValue& val, const Vector3& from)
 template<>
 void Jsonify::JsonSerde::deserialize(const JsonValue& val, Vector3& from)
 {
-	from.x = val[0].as<double>();
-	from.y = val[1].as<double>();
-	from.z = val[2].as<double>();
+	from.x = val.get<double>(0);
+	from.y = val.get<double>(1);
+	from.z = val.get<double>(2);
 }
 
 int main()
@@ -0,0 +1,39 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "Jsonify.h"
+
+int main()
+{
+	std::string source = "[";
+	for (int i = 0; i < 100000; i++)
+	{
+		if (i > 0) source.append(",");
+
+		source.append("{\"id\": " + std::to_string(i) + ", \"name\": \"item\", \"tags\": [true, false, null], \"score\": 12.5}");
+	}
+	source.append("]");
+
+	const int runs = 20;
+	std::size_t tokens = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int run = 0; run < runs; run++)
+	{
+		Jsonify::Lexer lexer(source);
+
+		while (lexer.nextToken().type != Jsonify::Token::Type::Eof)
+		{
+			tokens++;
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << tokens << " tokens in " << elapsed.count() << "s" << std::endl;
+	std::cout << (tokens / elapsed.count()) / 1e6 << " million tokens per second" << std::endl;
+
+	return 0;
+}
\ No newline at end of file
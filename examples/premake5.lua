@@ -32,4 +32,28 @@ project "JsonifyExamples"
 		optimize "On"
 		symbols "Off"
 
+project "LexerBenchmark"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+
+	includedirs {"../include"}
+
+	targetdir "bin/%{cfg.buildcfg}"
+	objdir "obj/%{cfg.buildcfg}"
+
+	files {"LexerBenchmark.cpp"}
+
+	links {"Jsonify"}
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		optimize "Off"
+		symbols "On"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "On"
+		symbols "Off"
+
 include "../"
\ No newline at end of file
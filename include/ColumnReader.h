@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Lexer.h"
+#include "JsonValue.h"
+#include "ParseError.h"
+
+namespace Jsonify
+{
+	//one field of every row of an array of dictionaries, stored contiguously
+	struct Column
+	{
+		enum class Type
+		{
+			Number,
+			Integer,
+			String,
+			Boolean,
+		};
+
+		Column(std::string key, Type type);
+
+		std::string key;
+		Type type;
+
+		std::size_t rows = 0;
+
+		//only the vector for type is filled, with one entry per row that is zero where the row is null
+		std::vector<double> numbers;
+		std::vector<std::int64_t> integers;
+		std::vector<std::uint8_t> booleans;
+
+		//rows hold an index into dictionary, which has every distinct string once
+		std::vector<std::uint32_t> codes;
+		std::vector<std::string> dictionary;
+
+		//one bit per row, clear where the row was null or did not have the key
+		std::vector<std::uint64_t> validity;
+
+		bool isValid(std::size_t row) const;
+		std::string_view getString(std::size_t row) const;
+
+		//drops every row, the key, type and capacity are kept
+		void clear();
+	};
+
+	//fills columns from an array of dictionaries in one pass, keys that are not asked for are skipped
+	class ColumnReader
+	{
+	public:
+		struct Settings
+		{
+			//applies to the values that are skipped
+			std::size_t maxDepth = 512;
+		};
+
+		ColumnReader();
+		ColumnReader(Settings settings);
+
+		//straight from the input without building a JsonValue, the columns are cleared first
+		//a value that does not fit its column, an integer too large for int64 included, fails with UnexpectedType
+		void read(std::string_view in, std::vector<Column>& columns);
+		bool tryRead(std::string_view in, std::vector<Column>& columns, ParseError& error);
+
+		//same from an array of dictionaries that is already parsed
+		void readValue(const JsonValue& rows, std::vector<Column>& columns);
+
+	private:
+		typedef std::unordered_map<std::string, std::uint32_t, JsonValue::KeyHash, JsonValue::KeyEqual> StringCodes;
+
+		bool readRows(std::vector<Column>& columns, ParseError& error);
+		bool readRow(std::vector<Column>& columns, ParseError& error);
+		bool readField(Column& column, StringCodes& codes, ParseError& error);
+		bool readKey(ParseError& error);
+		bool skipValue(ParseError& error);
+
+		void reset(std::vector<Column>& columns);
+		void setString(Column& column, StringCodes& codes, std::string_view str);
+
+		Settings settings;
+
+		Lexer lexer;
+
+		//one per column, the strings already in its dictionary
+		std::vector<StringCodes> stringCodes;
+
+		//containers open while skipping, true for arrays
+		std::vector<bool> skipped;
+
+		//the current key when it had to be unescaped
+		std::string unescaped;
+		std::string_view key;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "JsonValue.h"
+
+namespace Jsonify
+{
+	class FrozenDocument;
+
+	struct FrozenNode
+	{
+		struct StringRef
+		{
+			std::uint32_t offset;
+
+			//low bits of the hash of a key, checked before the text
+			std::uint32_t hash;
+		};
+
+		struct ContainerRef
+		{
+			//children are stored together from here, dictionaries alternate key and value
+			std::uint32_t first;
+
+			//dictionaries only, where their table of bitCeil(2 * count) slots starts
+			std::uint32_t slots;
+		};
+
+		JsonValue::Type type;
+
+		//elements or members of a container, length of a string or of the text of a raw number, 0 for other numbers
+		std::uint32_t count;
+
+		union
+		{
+			double number;
+			bool boolean;
+
+			//strings, and numbers that kept their text
+			StringRef string;
+			ContainerRef container;
+		};
+	};
+
+	//a view into a FrozenDocument, which has to outlive it
+	class FrozenValue
+	{
+	public:
+		JsonValue::Type getType() const;
+		bool isNull() const;
+
+		std::size_t size() const;
+
+		//missing keys and indices throw, like the const lookups of JsonValue
+		FrozenValue operator[](std::string_view key) const;
+		FrozenValue operator[](const JsonValue::Key& key) const;
+		FrozenValue operator[](std::size_t index) const;
+
+		bool contains(std::string_view key) const;
+		bool contains(const JsonValue::Key& key) const;
+
+		//members of a dictionary by position, ordered by key
+		std::string_view getKey(std::size_t index) const;
+		FrozenValue getValue(std::size_t index) const;
+
+		std::string_view getString() const;
+		double getNumber() const;
+		bool getBoolean() const;
+
+		//raw numbers are frozen with their text, which getNumber converts on each call as JsonValue does
+		bool isRawNumber() const;
+		std::string_view getRawNumber() const;
+
+		void toValue(JsonValue& value) const;
+
+	private:
+		FrozenValue(const FrozenDocument* document, std::uint32_t index);
+
+		const FrozenNode& getNode() const;
+
+		//index of the member's key node, or npos
+		std::size_t findMember(std::string_view key, std::uint32_t hash) const;
+
+		const FrozenDocument* document;
+		std::uint32_t index;
+
+		friend class FrozenDocument;
+	};
+
+	//an immutable copy of a JsonValue in a single allocation, safe to read from any number of threads
+	//every dictionary gets an open addressing table that is at most half full, so a lookup rarely probes twice
+	class FrozenDocument
+	{
+	public:
+		explicit FrozenDocument(const JsonValue& value);
+
+		FrozenDocument(const FrozenDocument&) = delete;
+		FrozenDocument& operator=(const FrozenDocument&) = delete;
+
+		FrozenValue getRoot() const;
+
+		//bytes held by the document
+		std::size_t getSize() const;
+
+	private:
+		//nodes, then the slots of every dictionary, then the text of every string and key
+		std::unique_ptr<std::byte[]> storage;
+		std::size_t size;
+
+		const FrozenNode* nodes;
+
+		//member number + 1 of the key in each slot, 0 when empty
+		const std::uint32_t* slots;
+		const char* chars;
+
+		friend class FrozenValue;
+	};
+}
\ No newline at end of file
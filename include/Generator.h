@@ -0,0 +1,161 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace Jsonify
+{
+	//a coroutine that hands out one T& per co_yield, read with a range for
+	//values are produced lazily, only when the loop asks for the next one
+	template<typename T>
+	class Generator
+	{
+	public:
+		struct promise_type
+		{
+			T* value = nullptr;
+			std::exception_ptr exception;
+
+			inline Generator get_return_object()
+			{
+				return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			inline std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			inline std::suspend_always final_suspend() noexcept
+			{
+				return {};
+			}
+
+			inline std::suspend_always yield_value(T& from) noexcept
+			{
+				value = std::addressof(from);
+
+				return {};
+			}
+
+			//a temporary lives until the coroutine is resumed
+			inline std::suspend_always yield_value(T&& from) noexcept
+			{
+				value = std::addressof(from);
+
+				return {};
+			}
+
+			inline void return_void()
+			{
+			}
+
+			inline void unhandled_exception()
+			{
+				exception = std::current_exception();
+			}
+		};
+
+		class Iterator
+		{
+		public:
+			typedef std::ptrdiff_t difference_type;
+			typedef T value_type;
+
+			inline Iterator()
+				: handle(nullptr)
+			{
+			}
+
+			inline explicit Iterator(std::coroutine_handle<promise_type> handle)
+				: handle(handle)
+			{
+			}
+
+			inline T& operator*() const
+			{
+				return *handle.promise().value;
+			}
+
+			inline Iterator& operator++()
+			{
+				advance(handle);
+
+				return *this;
+			}
+
+			inline void operator++(int)
+			{
+				++*this;
+			}
+
+			inline bool operator==(std::default_sentinel_t) const
+			{
+				return !handle || handle.done();
+			}
+
+		private:
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		inline Generator(Generator&& other) noexcept
+			: handle(std::exchange(other.handle, nullptr))
+		{
+		}
+
+		inline Generator& operator=(Generator&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (handle) handle.destroy();
+
+				handle = std::exchange(other.handle, nullptr);
+			}
+
+			return *this;
+		}
+
+		Generator(const Generator&) = delete;
+		Generator& operator=(const Generator&) = delete;
+
+		//starts the coroutine, it can only be iterated once
+		inline Iterator begin()
+		{
+			advance(handle);
+
+			return Iterator(handle);
+		}
+
+		inline std::default_sentinel_t end() const
+		{
+			return std::default_sentinel;
+		}
+
+		inline ~Generator()
+		{
+			if (handle) handle.destroy();
+		}
+
+	private:
+		inline explicit Generator(std::coroutine_handle<promise_type> handle)
+			: handle(handle)
+		{
+		}
+
+		//exceptions thrown inside the coroutine come out of here, in the loop that reads it
+		inline static void advance(std::coroutine_handle<promise_type> handle)
+		{
+			if (!handle || handle.done()) return;
+
+			handle.resume();
+
+			if (handle.promise().exception)
+				std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+		}
+
+		std::coroutine_handle<promise_type> handle;
+	};
+}
\ No newline at end of file
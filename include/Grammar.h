@@ -0,0 +1,142 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <vector>
+
+#include "Lexer.h"
+#include "ParseError.h"
+#include "StringUtils.h"
+
+namespace Jsonify
+{
+	//the one walk of the json grammar every token by token reader drives, so they all accept exactly the same input
+	//reads a value from the current token on and leaves the token after it current, reporting it to handler as it goes:
+	//   bool scalar(const Token& tok, ParseError& error)                      null, boolean, string or number
+	//   bool key(const Token& tok, ParseError& error)                         a string token, before its colon is checked
+	//   bool beginContainer(bool isArray, const Token& tok, ParseError& error) tok is the opening bracket, the token after it is current
+	//   bool endContainer(bool isArray, const Token& tok, ParseError& error)   tok is the closing bracket, still current
+	//numbers are checked against the grammar before they are reported, string contents are left to the handler since most decode them anyway
+	//a handler returning false stops the walk, it is expected to have filled in error
+	//open is scratch space for the containers being read, true for arrays
+	template<typename Handler>
+	bool walkValue(Lexer& lexer, Handler& handler, std::vector<bool>& open, std::size_t maxDepth, ParseError& error)
+	{
+		open.clear();
+
+		auto readKey = [&]() -> bool
+		{
+			const Token& tokKey = lexer.readToken();
+
+			if (tokKey.type != Token::Type::String)
+				return error.fail(ParseError::Kind::MalformedKey, tokKey);
+
+			if (!handler.key(tokKey, error)) return false;
+
+			if (!lexer.nextToken().isChar(':'))
+				return error.fail(ParseError::Kind::ExpectedColon, lexer.readToken());
+
+			lexer.nextToken();
+
+			return true;
+		};
+
+		while (true)
+		{
+			const Token& tok = lexer.readToken();
+
+			switch (tok.type)
+			{
+			case Token::Type::Number:
+				if (!isNumberLiteral(tok.rawValue))
+					return error.fail(ParseError::Kind::MalformedNumber, tok);
+
+				[[fallthrough]];
+
+			case Token::Type::Null:
+			case Token::Type::Boolean:
+			case Token::Type::String:
+				if (!handler.scalar(tok, error)) return false;
+
+				lexer.nextToken();
+				break;
+
+			case Token::Type::Eof:
+				return error.fail(ParseError::Kind::UnexpectedEnd, tok);
+
+			case Token::Type::Char:
+			{
+				if (!tok.isChar('[') && !tok.isChar('{'))
+					return error.fail(ParseError::Kind::UnknownCharacter, tok);
+
+				if (open.size() >= maxDepth)
+					return error.fail(ParseError::Kind::TooDeep, tok);
+
+				bool isArray = tok.isChar('[');
+
+				//tok is the lexer's current token, which is about to move on
+				Token start = tok;
+				lexer.nextToken();
+
+				if (!handler.beginContainer(isArray, start, error)) return false;
+
+				if (!lexer.readToken().isChar(isArray ? ']' : '}'))
+				{
+					open.push_back(isArray);
+
+					if (!isArray && !readKey()) return false;
+
+					continue;
+				}
+
+				if (!handler.endContainer(isArray, lexer.readToken(), error)) return false;
+
+				lexer.nextToken();
+				break;
+			}
+
+			default:
+				return error.fail(ParseError::Kind::UnknownToken, tok);
+			}
+
+			//the value is done, close every container that ends here
+			while (true)
+			{
+				if (open.empty()) return true;
+
+				bool isArray = open.back();
+
+				if (lexer.readToken().isChar(','))
+				{
+					lexer.nextToken();
+
+					if (!isArray && !readKey()) return false;
+
+					break;
+				}
+
+				if (lexer.isEnd())
+					return error.fail(ParseError::Kind::UnexpectedEnd, lexer.readToken());
+
+				if (!lexer.readToken().isChar(isArray ? ']' : '}'))
+					return error.fail(isArray ? ParseError::Kind::MissingArrayEnd : ParseError::Kind::MissingDictionaryEnd, lexer.readToken());
+
+				if (!handler.endContainer(isArray, lexer.readToken(), error)) return false;
+
+				open.pop_back();
+				lexer.nextToken();
+			}
+		}
+	}
+
+	//converts a number the walk has already checked, so only its range can be wrong
+	inline bool toNumber(const Token& tok, double& num, ParseError& error)
+	{
+		std::string_view raw = tok.rawValue;
+
+		if (std::from_chars(raw.data(), raw.data() + raw.size(), num).ec == std::errc::result_out_of_range)
+			return error.fail(ParseError::Kind::NumberOutOfRange, tok);
+
+		return true;
+	}
+}
\ No newline at end of file
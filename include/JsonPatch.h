@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+#include "JsonValue.h"
+
+namespace Jsonify
+{
+	struct JsonPatch
+	{
+		//RFC 6902, the document is left untouched if any operation fails
+		static void apply(JsonValue& document, const JsonValue& patch);
+		static void apply(JsonValue& document, JsonValue&& patch);
+
+		//RFC 7396
+		static void applyMerge(JsonValue& document, const JsonValue& patch);
+
+		static JsonValue diff(const JsonValue& from, const JsonValue& to);
+
+		JsonPatch() = delete;
+	private:
+		static void diffValues(const JsonValue& from, const JsonValue& to, std::string& path, JsonValue& patch);
+	};
+}
\ No newline at end of file
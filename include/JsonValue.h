@@ -1,9 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <stdexcept>
+#include <type_traits>
 
 #include "JsonSerdes.h"
 
@@ -12,7 +20,67 @@ namespace Jsonify
 	class JsonValue
 	{
 	public:
-		typedef std::unordered_map<std::string, JsonValue>::iterator Iterator;
+		//strings, arrays and dictionaries allocate from this, children use the allocator of their parent
+		typedef std::pmr::polymorphic_allocator<> allocator_type;
+
+		//a dictionary key hashed once up front, for looking the same key up in many dictionaries
+		//the text is not copied and has to outlive the key, a KeyTable keeps it alive
+		struct Key
+		{
+			inline explicit Key(std::string_view name)
+				: name(name), hash(std::hash<std::string_view>()(name))
+			{
+			};
+
+			inline bool operator==(const Key& other) const
+			{
+				//keys from the same table share their text
+				return name.data() == other.name.data() ? name.size() == other.name.size() : name == other.name;
+			};
+
+			std::string_view name;
+			std::size_t hash;
+		};
+
+		//transparent so members can be looked up without converting the key to a pmr::string
+		struct KeyHash
+		{
+			typedef void is_transparent;
+
+			std::size_t operator()(std::string_view key) const
+			{
+				return std::hash<std::string_view>()(key);
+			}
+
+			std::size_t operator()(const Key& key) const
+			{
+				return key.hash;
+			}
+		};
+
+		struct KeyEqual
+		{
+			typedef void is_transparent;
+
+			bool operator()(std::string_view a, std::string_view b) const
+			{
+				return a == b;
+			}
+
+			bool operator()(const Key& a, std::string_view b) const
+			{
+				return a.name == b;
+			}
+
+			bool operator()(std::string_view a, const Key& b) const
+			{
+				return a == b.name;
+			}
+		};
+
+		typedef std::pmr::unordered_map<std::pmr::string, JsonValue, KeyHash, KeyEqual> Map;
+		typedef Map::iterator Iterator;
+		typedef Map::const_iterator ConstIterator;
 
 		enum class Type
 		{
@@ -32,11 +100,37 @@ namespace Jsonify
 
 		template<typename T>
 		inline JsonValue(T t)
-			: type(Type::Null), b(0)
+			: type(Type::Null), hashCache(0), b(0)
 		{
 			JsonSerde::serialize(*this, t);
 		};
 
+		//allocator-extended forms, also used by the pmr containers when they construct elements
+		JsonValue(std::allocator_arg_t, const allocator_type& allocator);
+		JsonValue(std::allocator_arg_t, const allocator_type& allocator, const JsonValue& other);
+		JsonValue(std::allocator_arg_t, const allocator_type& allocator, JsonValue&& other);
+
+		//t is converted straight into the resource, never into the default one first
+		template<typename T>
+		inline JsonValue(std::allocator_arg_t, const allocator_type& allocator, T t)
+			: JsonValue(std::allocator_arg, allocator)
+		{
+			if constexpr (std::is_convertible_v<const T&, std::string_view>)
+			{
+				setType(Type::String);
+				s.assign(std::string_view(t));
+			}
+			else if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, Null>)
+			{
+				//nothing to allocate
+				*this = JsonValue(t);
+			}
+			else
+			{
+				JsonSerde::serialize(*this, t);
+			}
+		};
+
 		JsonValue(double n);
 		JsonValue(int n);
 		JsonValue(float n);
@@ -47,9 +141,12 @@ namespace Jsonify
 		
 		JsonValue(Null);
 
+		//as with the standard pmr containers, a copy uses the default resource and a move keeps the source's
 		JsonValue(const JsonValue& other);
 		JsonValue(JsonValue&& other) noexcept;
 		
+		allocator_type get_allocator() const;
+
 		void setType(Type type);
 		Type getType() const;
 
@@ -61,29 +158,93 @@ namespace Jsonify
 		bool isNull() const;
 		bool isTruthful() const;
 
+		//arrays of numbers can be stored as a flat buffer of doubles instead of one node per element
+		bool isPacked() const;
+
+		//packs an array holding only numbers, returns false if it holds anything else
+		bool pack();
+
+		//gives a packed array one node per element again, so they can be indexed and given any type
+		void unpack();
+
+		//numbers can keep the text they were read from, which is converted on each as<T>() and written back unchanged
+		bool isRawNumber() const;
+		std::string_view getRawNumber() const;
+
+		//assignment never changes the allocator, contents are copied into it when the resources differ
 		JsonValue& operator=(JsonValue&& other) noexcept;
 		JsonValue& operator=(const JsonValue& other);
 
 		bool operator==(const JsonValue& other) const;
 		bool operator!=(const JsonValue& other) const;
 
+		//structural hash, cached on dictionaries and arrays until they are changed
+		//one that has handed out a mutable reference into itself is never cached, the reference could change it unseen
+		std::uint64_t hash() const;
+
 		//map
 		JsonValue& getOrDefault(const std::string& key, const JsonValue& defaultValue);
 		JsonValue& operator[](const std::string& key);
 		const JsonValue& operator[](const std::string& key) const;
 		void remove(const std::string& key);
 		bool contains(const std::string& key) const;
+
+		//same lookups without hashing the key again
+		JsonValue& operator[](const Key& key);
+		const JsonValue& operator[](const Key& key) const;
+		bool contains(const Key& key) const;
 		
 		//array
+		//a packed array has no element nodes to hand out and throws, read it with get or asSpan or unpack it first
 		JsonValue& operator[](std::size_t index);
 		const JsonValue& operator[](std::size_t index) const;
+
+		//one element converted to T, or copied out when T is JsonValue, packed arrays convert straight from their doubles and stay packed
+		template<typename T>
+		inline T get(std::size_t index) const
+		{
+			if (type != Type::Array) throw std::runtime_error("Type is not an array");
+			if (index >= size()) throw std::runtime_error("Array index out of range");
+
+			if constexpr (std::is_same_v<T, JsonValue>)
+				return packed ? JsonValue(p.values[index]) : v[index];
+			else
+				return packed ? JsonValue(p.values[index]).as<T>() : v[index].as<T>();
+		};
+
 		void push_back(JsonValue& val);
 		void push_back(JsonValue&& val);
+		void insert(std::size_t index, JsonValue&& val);
+		void remove(std::size_t index);
 		void reserve(std::size_t amount);
 		void resize(std::size_t to);
 
 		std::size_t size() const;
 
+		//elements of a packed array, the non-const form keeps it packed while the numbers are edited
+		template<typename T>
+		inline std::span<const T> asSpan() const
+		{
+			static_assert(std::is_same_v<T, double>, "Packed arrays hold doubles");
+
+			if (type != Type::Array || !packed) throw std::runtime_error("Type is not a packed array");
+
+			return p.values;
+		};
+
+		template<typename T>
+		inline std::span<T> asSpan()
+		{
+			static_assert(std::is_same_v<T, double>, "Packed arrays hold doubles");
+
+			if (type != Type::Array || !packed) throw std::runtime_error("Type is not a packed array");
+
+			invalidateHash();
+			exposed = true;
+
+			return p.values;
+		};
+
 		//boolean
 		bool operator!() const;
 		explicit operator bool() const;
@@ -101,19 +262,62 @@ namespace Jsonify
 		Iterator begin();
 		Iterator end();
 
+		//never modify the value, so any number of threads can read one that is not being written
+		ConstIterator begin() const;
+		ConstIterator end() const;
+
 		~JsonValue();
 		
 		friend struct JsonSerde;
+		friend struct JsonPatch;
 		friend class StringWriter;
 		friend class StringReader;
+		friend class ColumnReader;
+		friend class FrozenDocument;
+		friend class FrozenValue;
 	private:
+		struct PackedArray
+		{
+			PackedArray(const allocator_type& allocator);
+
+			std::pmr::vector<double> values;
+		};
+
+		void invalidateHash();
+
+		void setPacked();
+
+		//text has to be a valid json number
+		void setRawNumber(std::string_view text);
+
+		double number() const;
+
+		//exact for raw numbers that are written as integers
+		template<typename T>
+		T integer() const;
+
 		Type type;
+
+		//array storage is p rather than v, only read when type is Array
+		bool packed = false;
+
+		//number storage is the text in s rather than n, only read when type is Number
+		bool rawNumber = false;
+
+		//set once a mutable reference into the array or dictionary has been handed out, its hash is then never cached
+		bool exposed = false;
+
+		//0 when not computed
+		mutable std::atomic<std::uint64_t> hashCache;
+
+		allocator_type allocator;
 	
 		union
 		{
-			std::string s;
-			std::vector<JsonValue> v;
-			std::unordered_map<std::string, JsonValue> m;
+			std::pmr::string s;
+			std::pmr::vector<JsonValue> v;
+			Map m;
+			PackedArray p;
 
 			double n;
 			bool b;
@@ -135,7 +339,7 @@ namespace Jsonify
 	{
 		if (val.type != JsonValue::Type::Number) throw std::runtime_error("Type mismatch, expected a number");
 
-		res = (int)val.n;
+		res = (int)val.number();
 	}
 
 
@@ -153,7 +357,7 @@ namespace Jsonify
 	{
 		if (val.type != JsonValue::Type::Number) throw std::runtime_error("Type mismatch, expected a number");
 
-		res = (float)val.n;
+		res = (float)val.number();
 	}
 
 	//double
@@ -170,7 +374,24 @@ namespace Jsonify
 	{
 		if (val.type != JsonValue::Type::Number) throw std::runtime_error("Type mismatch, expected a number");
 
-		res = val.n;
+		res = val.number();
+	}
+
+	//64 bit integers, exact when the number was read raw
+	template<>
+	inline static void JsonSerde::deserialize(const JsonValue& val, std::int64_t& res)
+	{
+		if (val.type != JsonValue::Type::Number) throw std::runtime_error("Type mismatch, expected a number");
+
+		res = val.integer<std::int64_t>();
+	}
+
+	template<>
+	inline static void JsonSerde::deserialize(const JsonValue& val, std::uint64_t& res)
+	{
+		if (val.type != JsonValue::Type::Number) throw std::runtime_error("Type mismatch, expected a number");
+
+		res = val.integer<std::uint64_t>();
 	}
 
 	//boolean
@@ -219,6 +440,15 @@ namespace Jsonify
 	{
 		if (val.type != JsonValue::Type::String) throw std::runtime_error("Type mismatch, expected a string");
 		
-		res = val.s;
+		res.assign(val.s);
+	}
+}
+
+template<>
+struct std::hash<Jsonify::JsonValue>
+{
+	std::size_t operator()(const Jsonify::JsonValue& value) const
+	{
+		return (std::size_t)value.hash();
 	}
-}
\ No newline at end of file
+};
\ No newline at end of file
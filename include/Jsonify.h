@@ -2,6 +2,17 @@
 
 #include "JsonSerdes.h"
 #include "JsonValue.h"
+#include "JsonPatch.h"
 
+#include "ParseError.h"
 #include "StringWriter.h"
-#include "StringReader.h"
\ No newline at end of file
+#include "StringReader.h"
+#include "Tape.h"
+#include "ColumnReader.h"
+#include "KeyTable.h"
+#include "FrozenDocument.h"
+#include "SharedDocument.h"
+#include "Schema.h"
+#include "StreamReader.h"
+#include "Query.h"
+#include "StaticJson.h"
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#include "JsonValue.h"
+
+namespace Jsonify
+{
+	//stores each distinct key once, the keys it hands out stay valid for as long as the table lives
+	//safe to use from several threads, repeated keys only take a shared lock
+	class KeyTable
+	{
+	public:
+		KeyTable() = default;
+
+		KeyTable(const KeyTable&) = delete;
+		KeyTable& operator=(const KeyTable&) = delete;
+
+		//keys for the same text always share it, so they compare by pointer
+		JsonValue::Key intern(std::string_view name);
+
+		std::size_t size() const;
+
+	private:
+		//nodes never move, so the text of every key stays where it is
+		std::unordered_set<std::string, JsonValue::KeyHash, JsonValue::KeyEqual> keys;
+
+		mutable std::shared_mutex mutex;
+	};
+}
\ No newline at end of file
@@ -1,8 +1,6 @@
 #pragma once
 
 #include <cstddef>
-#include <deque>
-#include <string>
 #include <string_view>
 
 #include "Location.h"
@@ -31,30 +29,43 @@ namespace Jsonify
 		Location location;
 
 		std::string_view rawValue;
+
+		inline bool isChar(char c) const
+		{
+			return type == Type::Char && rawValue[0] == c;
+		}
 	};
 
 	class Lexer
 	{
 	public:
-		Lexer(const std::string& source);
+		//source is not copied and has to outlive the lexer
+		Lexer(std::string_view source = std::string_view());
+
+		//starts over on a new source, nothing is reallocated
+		void reset(std::string_view source);
 		
 		const Token& readToken() const;
 		const Token& nextToken();
-		const Token& peekToken(int amount = 1);
+
+		//continues from offset in the source, skipping everything before it
+		const Token& seek(std::size_t offset);
+
+		//lexes ahead and rewinds, nothing is buffered
+		Token peekToken(int amount = 1);
 
 		bool isEnd() const;
 	private:
-		const Token parseToken();
+		Token parseToken();
 
-		std::deque<Token> tokens;
+		Token current;
 
 		char consume();
 		char readChar() const;
 		char peekChar(std::size_t offset = 1) const;
 
-		std::string source;
+		std::string_view source;
 
-		int lineNumber;
 		std::size_t pointer;
 	};
 
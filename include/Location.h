@@ -6,9 +6,8 @@ namespace Jsonify
 {
 	struct Location
 	{
+		//byte offsets into the source, lines and columns are only worked out when an error is reported
 		std::size_t start;
 		std::size_t end;
-
-		int line;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Jsonify
+{
+	struct Token;
+
+	struct ParseError
+	{
+		enum class Kind
+		{
+			None,
+
+			UnexpectedEnd,
+			TrailingContent,
+			UnknownToken,
+			UnknownCharacter,
+			MalformedString,
+			MalformedNumber,
+			NumberOutOfRange,
+			MalformedKey,
+			ExpectedColon,
+			MissingArrayEnd,
+			MissingDictionaryEnd,
+			TooDeep,
+			TooLarge,
+
+			//well formed, but not the type the caller asked for
+			UnexpectedType,
+
+			//well formed, but rejected by the Schema being checked against
+			SchemaViolation,
+		};
+
+		Kind kind = Kind::None;
+
+		//offset of the offending token in the input, line and column count from 1
+		std::size_t offset = 0;
+		int line = 0;
+		std::size_t column = 0;
+
+		//records kind at tok and returns false, so a parser can fail in one return
+		bool fail(Kind kind, const Token& tok);
+
+		//fills line and column from offset
+		void locate(std::string_view source);
+
+		//only formatted when asked for, the error itself never allocates
+		std::string message() const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "JsonValue.h"
+
+namespace Jsonify
+{
+	struct QueryResult
+	{
+		struct Group
+		{
+			//value of the groupBy field, null when not grouping or when the row did not have it
+			JsonValue key;
+
+			std::uint64_t rows = 0;
+
+			//one per aggregate in the order they were added, Min, Max and Mean are NaN when no row had a number for them
+			std::vector<double> values;
+		};
+
+		//ordered by key, numbers before strings, then booleans, then null
+		std::vector<Group> groups;
+
+		//lines that were not well formed, only counted when Settings::skipMalformed is set
+		std::uint64_t malformed = 0;
+	};
+
+	//aggregates the lines of NDJSON text across threads, reading only the fields it refers to
+	//containers nothing refers to are only checked for matching brackets and terminated strings, which is what keeps the scan fast
+	//fields are JSON pointers into nested dictionaries, such as "/user/id"
+	class Query
+	{
+	public:
+		struct Settings
+		{
+			//0 uses one per hardware thread
+			std::size_t threads = 0;
+
+			//malformed lines are counted and skipped instead of failing the query
+			bool skipMalformed = false;
+
+			std::size_t maxDepth = 512;
+		};
+
+		enum class Compare
+		{
+			Equal,
+			NotEqual,
+			Less,
+			LessEqual,
+			Greater,
+			GreaterEqual,
+
+			//the operand is ignored
+			Exists,
+		};
+
+		enum class Aggregate
+		{
+			Sum,
+			Min,
+			Max,
+			Mean,
+
+			//rows that have the field, whatever its type
+			Count,
+		};
+
+		Query();
+		Query(Settings settings);
+
+		//rows are kept only when they pass every filter, a missing field only passes NotEqual
+		Query& where(const std::string& field, Compare compare, const JsonValue& operand = JsonValue());
+
+		Query& groupBy(const std::string& field);
+
+		//values that are not numbers are ignored, except by Count
+		Query& aggregate(Aggregate aggregate, const std::string& field);
+
+		//the file is memory mapped and split between the threads at line boundaries
+		QueryResult runFile(const std::string& path) const;
+		QueryResult run(std::string_view text) const;
+
+	private:
+		class Scanner;
+
+		struct Filter
+		{
+			std::size_t field;
+			Compare compare;
+			JsonValue operand;
+
+			//the operand converted once in where, so rows are compared without copying it
+			std::string text;
+			double number = 0;
+		};
+
+		struct Output
+		{
+			std::size_t field;
+			Aggregate aggregate;
+		};
+
+		//each distinct path is read once however many filters and aggregates use it
+		std::size_t addField(const std::string& pointer);
+
+		Settings settings;
+
+		std::vector<std::vector<std::string>> fields;
+		std::vector<Filter> filters;
+		std::vector<Output> outputs;
+
+		//npos when not grouping
+		std::size_t group;
+	};
+}
\ No newline at end of file
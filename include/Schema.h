@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Lexer.h"
+#include "JsonValue.h"
+#include "ParseError.h"
+
+namespace Jsonify
+{
+	//a JSON Schema compiled into a table of nodes, immutable and safe to share between threads
+	//supports type, enum, const, minimum, maximum, exclusiveMinimum, exclusiveMaximum, minLength, maxLength,
+	//properties, required, additionalProperties, minProperties, maxProperties, items, minItems and maxItems
+	//keywords that could change the result but are not supported are rejected, the rest are ignored
+	class Schema
+	{
+	public:
+		explicit Schema(const JsonValue& schema);
+
+	private:
+		//one bit per JsonValue::Type, Integer is checked on top of Number
+		enum TypeBit : std::uint8_t
+		{
+			String = 1 << 0,
+			Number = 1 << 1,
+			Dictionary = 1 << 2,
+			Array = 1 << 3,
+			Boolean = 1 << 4,
+			Null = 1 << 5,
+			Integer = 1 << 6,
+
+			Any = String | Number | Dictionary | Array | Boolean | Null,
+		};
+
+		struct Property
+		{
+			std::uint32_t node;
+
+			//position among the required keys, or npos
+			std::uint32_t required;
+		};
+
+		struct Node
+		{
+			std::uint8_t types = Any;
+
+			double minimum = -std::numeric_limits<double>::infinity();
+			double maximum = std::numeric_limits<double>::infinity();
+			bool exclusiveMinimum = false;
+			bool exclusiveMaximum = false;
+
+			//strings count code points
+			std::size_t minLength = 0;
+			std::size_t maxLength = std::numeric_limits<std::size_t>::max();
+			std::size_t minItems = 0;
+			std::size_t maxItems = std::numeric_limits<std::size_t>::max();
+			std::size_t minProperties = 0;
+			std::size_t maxProperties = std::numeric_limits<std::size_t>::max();
+
+			std::unordered_map<std::string, Property, JsonValue::KeyHash, JsonValue::KeyEqual> properties;
+			std::uint32_t requiredCount = 0;
+
+			std::uint32_t additional = accept;
+			std::uint32_t items = accept;
+
+			//from enum and const, which only take scalars
+			bool restricted = false;
+			std::vector<std::string> allowedStrings;
+			std::vector<double> allowedNumbers;
+			bool allowedNull = false;
+			bool allowedFalse = false;
+			bool allowedTrue = false;
+		};
+
+		static constexpr std::uint32_t reject = 0;
+		static constexpr std::uint32_t accept = 1;
+		static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+		std::uint32_t compile(const JsonValue& schema, std::size_t depth);
+		void allow(Node& node, const JsonValue& value);
+
+		//index 0 rejects everything, index 1 accepts everything, the root is last
+		std::vector<Node> nodes;
+		std::uint32_t root;
+
+		friend class SchemaValidator;
+	};
+
+	//checks values against a Schema as they are read, one per thread
+	//the visit calls return false at the first value that breaks the schema and can be fed by any parser
+	class SchemaValidator
+	{
+	public:
+		struct Settings
+		{
+			//applies to validate
+			std::size_t maxDepth = 512;
+		};
+
+		explicit SchemaValidator(const Schema& schema);
+		SchemaValidator(const Schema& schema, Settings settings);
+
+		//parses in token by token without building a JsonValue, stopping at the first token that breaks the grammar or the schema
+		bool validate(std::string_view in, ParseError& error);
+
+		//starts over at the root of the schema
+		void reset();
+
+		bool visitNull();
+		bool visitBoolean(bool b);
+		bool visitNumber(double n);
+
+		//str is unescaped
+		bool visitString(std::string_view str);
+
+		bool beginArray();
+		bool beginDictionary();
+		bool visitKey(std::string_view key);
+
+		//closes the innermost array or dictionary
+		bool endContainer();
+
+	private:
+		struct Frame
+		{
+			std::uint32_t node;
+			bool isArray;
+			std::size_t count;
+
+			//where the bits for the required keys seen so far start
+			std::size_t seen;
+		};
+
+		//the node the next value is checked against, counting it as an element when inside an array
+		bool enter(std::uint8_t type, std::uint32_t& node);
+
+		const Schema* schema;
+		Settings settings;
+
+		Lexer lexer;
+
+		//containers open while validating, true for arrays
+		std::vector<bool> open;
+
+		std::vector<Frame> stack;
+		std::vector<std::uint64_t> seen;
+
+		//the node of the value after the current key
+		std::uint32_t next;
+
+		//strings and keys that had to be unescaped
+		std::string unescaped;
+	};
+}
\ No newline at end of file
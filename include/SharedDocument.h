@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "FrozenDocument.h"
+#include "JsonValue.h"
+#include "ParseError.h"
+#include "StringReader.h"
+
+namespace Jsonify
+{
+	//holds the latest version of a document that is replaced while other threads read it
+	//a version is freed once the last reader holding it moves on to a newer one
+	class SharedDocument
+	{
+	public:
+		//caches the version it last saw, one per reading thread
+		class Reader
+		{
+		public:
+			explicit Reader(const SharedDocument& shared);
+
+			//only touches the shared state when a new version was published since the last call
+			//the document returned stays valid until the next call
+			const FrozenDocument& get();
+
+		private:
+			const SharedDocument* shared;
+
+			std::uint64_t version;
+			std::shared_ptr<const FrozenDocument> document;
+		};
+
+		//starts out holding null
+		SharedDocument();
+		SharedDocument(StringReader::Settings settings);
+
+		SharedDocument(const SharedDocument&) = delete;
+		SharedDocument& operator=(const SharedDocument&) = delete;
+
+		void publish(const JsonValue& value);
+		void publish(std::shared_ptr<const FrozenDocument> document);
+
+		//parses in before anything is replaced, so readers never see a partial document
+		//named apart from publish since JsonValue converts from strings too
+		void publishText(std::string_view in);
+
+		//the current version is kept on failure
+		bool tryPublishText(std::string_view in, ParseError& error);
+
+		std::shared_ptr<const FrozenDocument> load() const;
+
+		//bumped by every publish
+		std::uint64_t getVersion() const;
+
+	private:
+		StringReader::Settings settings;
+
+		std::atomic<std::shared_ptr<const FrozenDocument>> document;
+
+		//readers poll this instead of the pointer, a plain load that never writes to the shared cache line
+		std::atomic<std::uint64_t> version;
+	};
+}
\ No newline at end of file
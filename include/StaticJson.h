@@ -0,0 +1,973 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "JsonValue.h"
+
+namespace Jsonify
+{
+	struct StaticNode
+	{
+		JsonValue::Type type = JsonValue::Type::Null;
+
+		//children of a container, bytes of a string
+		std::uint32_t count = 0;
+
+		//first child of a container, first byte of a string, dictionaries alternate key and value
+		std::uint32_t offset = 0;
+
+		bool boolean = false;
+		double number = 0;
+	};
+
+	//a view into a StaticDocument, every lookup can run at compile time
+	class StaticValue
+	{
+	public:
+		inline constexpr StaticValue(const StaticNode* nodes, const char* chars, std::uint32_t index)
+			: nodes(nodes), chars(chars), index(index)
+		{
+		}
+
+		inline constexpr JsonValue::Type getType() const
+		{
+			return nodes[index].type;
+		}
+
+		inline constexpr bool isNull() const
+		{
+			return getType() == JsonValue::Type::Null;
+		}
+
+		inline constexpr std::size_t size() const
+		{
+			if (getType() != JsonValue::Type::Array && getType() != JsonValue::Type::Dictionary)
+				throw std::runtime_error("Unable to get size of a type that is not Dictionary or Array");
+
+			return nodes[index].count;
+		}
+
+		//missing keys and indices throw, which fails the compile when it happens in a constant expression
+		inline constexpr StaticValue operator[](std::string_view key) const
+		{
+			std::size_t member = findMember(key);
+			if (member == (std::size_t)-1) throw std::out_of_range("Key not found");
+
+			return at(nodes[index].offset + 2 * (std::uint32_t)member + 1);
+		}
+
+		inline constexpr StaticValue operator[](std::size_t i) const
+		{
+			if (getType() != JsonValue::Type::Array) throw std::runtime_error("Type is not an array");
+			if (i >= nodes[index].count) throw std::out_of_range("Array index out of range");
+
+			return at(nodes[index].offset + (std::uint32_t)i);
+		}
+
+		inline constexpr bool contains(std::string_view key) const
+		{
+			return findMember(key) != (std::size_t)-1;
+		}
+
+		//members of a dictionary by position, ordered by key
+		inline constexpr std::string_view getKey(std::size_t i) const
+		{
+			if (getType() != JsonValue::Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+			if (i >= nodes[index].count) throw std::out_of_range("Member index out of range");
+
+			return at(nodes[index].offset + 2 * (std::uint32_t)i).getString();
+		}
+
+		inline constexpr StaticValue getValue(std::size_t i) const
+		{
+			if (getType() != JsonValue::Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+			if (i >= nodes[index].count) throw std::out_of_range("Member index out of range");
+
+			return at(nodes[index].offset + 2 * (std::uint32_t)i + 1);
+		}
+
+		inline constexpr std::string_view getString() const
+		{
+			if (getType() != JsonValue::Type::String) throw std::runtime_error("Type is not a string");
+
+			return std::string_view(chars + nodes[index].offset, nodes[index].count);
+		}
+
+		inline constexpr double getNumber() const
+		{
+			if (getType() != JsonValue::Type::Number) throw std::runtime_error("Type is not a number");
+
+			return nodes[index].number;
+		}
+
+		inline constexpr bool getBoolean() const
+		{
+			if (getType() != JsonValue::Type::Boolean) throw std::runtime_error("Type is not a boolean");
+
+			return nodes[index].boolean;
+		}
+
+		//a mutable copy, at run time
+		inline void toValue(JsonValue& value) const
+		{
+			value = JsonValue();
+
+			switch (getType())
+			{
+			case JsonValue::Type::Null:
+				break;
+
+			case JsonValue::Type::Boolean:
+				value = getBoolean();
+				break;
+
+			case JsonValue::Type::Number:
+				value = getNumber();
+				break;
+
+			case JsonValue::Type::String:
+				value = std::string(getString());
+				break;
+
+			case JsonValue::Type::Array:
+				value.resize(size());
+
+				for (std::size_t i = 0; i < size(); i++)
+					(*this)[i].toValue(value[i]);
+				break;
+
+			case JsonValue::Type::Dictionary:
+				value.setType(JsonValue::Type::Dictionary);
+
+				for (std::size_t i = 0; i < size(); i++)
+					getValue(i).toValue(value[std::string(getKey(i))]);
+				break;
+			}
+		}
+
+	private:
+		inline constexpr StaticValue at(std::uint32_t i) const
+		{
+			return StaticValue(nodes, chars, i);
+		}
+
+		//binary search, the builder sorts every dictionary by key
+		inline constexpr std::size_t findMember(std::string_view key) const
+		{
+			if (getType() != JsonValue::Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+
+			std::size_t low = 0;
+			std::size_t high = nodes[index].count;
+
+			while (low < high)
+			{
+				std::size_t middle = (low + high) / 2;
+				std::string_view candidate = at(nodes[index].offset + 2 * (std::uint32_t)middle).getString();
+
+				if (candidate == key) return middle;
+
+				if (candidate < key)
+					low = middle + 1;
+				else
+					high = middle;
+			}
+
+			return (std::size_t)-1;
+		}
+
+		const StaticNode* nodes;
+		const char* chars;
+		std::uint32_t index;
+	};
+
+	//a json literal parsed at compile time, sized exactly for it
+	template<std::size_t Nodes, std::size_t Chars>
+	struct StaticDocument
+	{
+		StaticNode nodes[Nodes] = {};
+
+		//never empty, arrays of size 0 are not allowed
+		char chars[Chars == 0 ? 1 : Chars] = {};
+
+		inline constexpr StaticValue getRoot() const
+		{
+			return StaticValue(nodes, chars, 0);
+		}
+	};
+
+	//the string given to a literal operator template
+	template<std::size_t N>
+	struct FixedString
+	{
+		char data[N];
+
+		inline constexpr FixedString(const char (&str)[N])
+		{
+			std::copy_n(str, N, data);
+		}
+
+		inline constexpr std::string_view view() const
+		{
+			return std::string_view(data, N - 1);
+		}
+	};
+
+	//not constexpr, so reaching it in a constant expression is a compile error that names it along with the reason
+	[[noreturn]] inline void staticJsonIsMalformed(const char* reason)
+	{
+		throw std::runtime_error(reason);
+	}
+
+	//unsigned integer of up to 4096 bits, enough to convert any number StaticParser accepts exactly
+	class StaticBigInt
+	{
+	public:
+		inline constexpr StaticBigInt(std::uint64_t value = 0)
+		{
+			for (; value != 0; value >>= 32)
+				push((std::uint32_t)value);
+		}
+
+		inline constexpr void multiplyAdd(std::uint32_t factor, std::uint32_t add)
+		{
+			std::uint64_t carry = add;
+
+			for (std::size_t i = 0; i < size; i++)
+			{
+				carry += (std::uint64_t)limbs[i] * factor;
+				limbs[i] = (std::uint32_t)carry;
+				carry >>= 32;
+			}
+
+			if (carry != 0) push((std::uint32_t)carry);
+		}
+
+		inline constexpr void multiplyPow10(std::size_t n)
+		{
+			for (; n >= 9; n -= 9)
+				multiplyAdd(1000000000, 0);
+
+			std::uint32_t rest = 1;
+			for (; n > 0; n--) rest *= 10;
+
+			multiplyAdd(rest, 0);
+		}
+
+		inline constexpr StaticBigInt shifted(std::size_t bits) const
+		{
+			StaticBigInt res;
+
+			for (std::size_t i = 0; i < bits / 32; i++)
+				res.push(0);
+
+			std::uint32_t carry = 0;
+
+			for (std::size_t i = 0; i < size; i++)
+			{
+				res.push(bits % 32 == 0 ? limbs[i] : limbs[i] << (bits % 32) | carry);
+				carry = bits % 32 == 0 ? 0 : limbs[i] >> (32 - bits % 32);
+			}
+
+			if (carry != 0) res.push(carry);
+
+			return res;
+		}
+
+		inline constexpr void halve()
+		{
+			for (std::size_t i = 0; i < size; i++)
+				limbs[i] = limbs[i] >> 1 | (i + 1 < size ? limbs[i + 1] << 31 : 0);
+
+			trim();
+		}
+
+		//other must not be larger
+		inline constexpr void subtract(const StaticBigInt& other)
+		{
+			std::int64_t borrow = 0;
+
+			for (std::size_t i = 0; i < size; i++)
+			{
+				std::int64_t diff = (std::int64_t)limbs[i] - (i < other.size ? other.limbs[i] : 0) - borrow;
+
+				borrow = diff < 0;
+				limbs[i] = (std::uint32_t)(diff + (borrow << 32));
+			}
+
+			trim();
+		}
+
+		inline constexpr int compare(const StaticBigInt& other) const
+		{
+			if (size != other.size) return size < other.size ? -1 : 1;
+
+			for (std::size_t i = size; i-- > 0;)
+				if (limbs[i] != other.limbs[i]) return limbs[i] < other.limbs[i] ? -1 : 1;
+
+			return 0;
+		}
+
+		inline constexpr std::size_t bitLength() const
+		{
+			return size == 0 ? 0 : (size - 1) * 32 + std::bit_width(limbs[size - 1]);
+		}
+
+	private:
+		static constexpr std::size_t capacity = 128;
+
+		inline constexpr void push(std::uint32_t limb)
+		{
+			if (size == capacity) staticJsonIsMalformed("Number is too long");
+
+			limbs[size++] = limb;
+		}
+
+		inline constexpr void trim()
+		{
+			while (size > 0 && limbs[size - 1] == 0) size--;
+		}
+
+		std::uint32_t limbs[capacity] = {};
+		std::size_t size = 0;
+	};
+
+	//parses with the same rules as StringReader, except that duplicate keys are rejected
+	class StaticParser
+	{
+	public:
+		struct Size
+		{
+			std::size_t nodes = 0;
+			std::size_t chars = 0;
+		};
+
+		inline constexpr explicit StaticParser(std::string_view source)
+			: source(source), pos(0)
+		{
+		}
+
+		//checks the whole source and counts what the document needs
+		inline constexpr Size measure()
+		{
+			Size size;
+
+			pos = 0;
+			skipWhitespace();
+			measureValue(size, 0);
+			skipWhitespace();
+
+			if (pos != source.size()) staticJsonIsMalformed("Json string unexpectedly continued after first object");
+
+			return size;
+		}
+
+		//breadth first, so the children of every container end up next to each other
+		template<std::size_t Nodes, std::size_t Chars>
+		inline constexpr StaticDocument<Nodes, Chars> build()
+		{
+			StaticDocument<Nodes, Chars> document;
+			Cursor cursor = { document.nodes, document.chars, 0, 0 };
+
+			pos = 0;
+			skipWhitespace();
+			placeValue(cursor);
+
+			for (std::size_t i = 0; i < cursor.nodes; i++)
+			{
+				StaticNode& node = document.nodes[i];
+
+				if (node.type != JsonValue::Type::Array && node.type != JsonValue::Type::Dictionary) continue;
+
+				//containers hold the offset of their opening bracket until they are reached here
+				pos = node.offset + 1;
+
+				std::uint32_t first = (std::uint32_t)cursor.nodes;
+				std::uint32_t count = 0;
+				bool isArray = node.type == JsonValue::Type::Array;
+
+				skipWhitespace();
+
+				while (source[pos] != (isArray ? ']' : '}'))
+				{
+					if (!isArray)
+					{
+						StaticNode& key = cursor.nodeData[cursor.nodes++];
+						key.type = JsonValue::Type::String;
+						key.offset = (std::uint32_t)cursor.chars;
+						key.count = (std::uint32_t)readString(cursor.charData + cursor.chars);
+						cursor.chars += key.count;
+
+						skipWhitespace();
+						pos++;
+						skipWhitespace();
+					}
+
+					placeValue(cursor);
+					count++;
+
+					skipWhitespace();
+					if (source[pos] == ',') pos++;
+					skipWhitespace();
+				}
+
+				node.offset = first;
+				node.count = count;
+
+				if (!isArray) sortMembers(document.nodes + first, count, document.chars);
+			}
+
+			return document;
+		}
+
+	private:
+		struct Cursor
+		{
+			StaticNode* nodeData;
+			char* charData;
+			std::size_t nodes;
+			std::size_t chars;
+		};
+
+		inline constexpr void measureValue(Size& size, std::size_t depth)
+		{
+			if (depth >= 512) staticJsonIsMalformed("Json string is nested too deeply");
+			if (pos >= source.size()) staticJsonIsMalformed("Json string unexpectedly ended");
+
+			size.nodes++;
+
+			char c = source[pos];
+
+			if (c == '{' || c == '[')
+			{
+				bool isArray = c == '[';
+
+				pos++;
+				skipWhitespace();
+
+				if (pos < source.size() && source[pos] == (isArray ? ']' : '}'))
+				{
+					pos++;
+					return;
+				}
+
+				while (true)
+				{
+					if (!isArray)
+					{
+						if (pos >= source.size() || source[pos] != '"') staticJsonIsMalformed("Missing or malformed key for dictionary");
+
+						size.nodes++;
+						size.chars += readString(nullptr);
+
+						skipWhitespace();
+						if (pos >= source.size() || source[pos] != ':') staticJsonIsMalformed("Expected a ':'");
+
+						pos++;
+						skipWhitespace();
+					}
+
+					measureValue(size, depth + 1);
+					skipWhitespace();
+
+					if (pos >= source.size()) staticJsonIsMalformed("Json string unexpectedly ended");
+
+					if (source[pos] == ',')
+					{
+						pos++;
+						skipWhitespace();
+
+						continue;
+					}
+
+					if (source[pos] != (isArray ? ']' : '}'))
+						staticJsonIsMalformed(isArray ? "Array does not have an ending bracket" : "Dictionary did not have an ending bracket");
+
+					pos++;
+					return;
+				}
+			}
+
+			if (c == '"')
+			{
+				size.chars += readString(nullptr);
+				return;
+			}
+
+			if (c == '-' || (c >= '0' && c <= '9'))
+			{
+				//the value is only needed when building, which checks the range again
+				readNumber(false);
+				return;
+			}
+
+			readKeyword();
+		}
+
+		//scalars are finished right away, containers only record where they start
+		inline constexpr void placeValue(Cursor& cursor)
+		{
+			StaticNode& node = cursor.nodeData[cursor.nodes++];
+			char c = source[pos];
+
+			if (c == '{' || c == '[')
+			{
+				node.type = c == '[' ? JsonValue::Type::Array : JsonValue::Type::Dictionary;
+				node.offset = (std::uint32_t)pos;
+
+				skipContainer();
+			}
+			else if (c == '"')
+			{
+				node.type = JsonValue::Type::String;
+				node.offset = (std::uint32_t)cursor.chars;
+				node.count = (std::uint32_t)readString(cursor.charData + cursor.chars);
+				cursor.chars += node.count;
+			}
+			else if (c == '-' || (c >= '0' && c <= '9'))
+			{
+				node.type = JsonValue::Type::Number;
+				node.number = readNumber(true);
+			}
+			else
+			{
+				node.boolean = source.substr(pos).starts_with("true");
+				node.type = readKeyword();
+			}
+		}
+
+		//only runs on source that measure already checked
+		inline constexpr void skipContainer()
+		{
+			std::size_t depth = 0;
+
+			do
+			{
+				char c = source[pos];
+
+				if (c == '"')
+				{
+					readString(nullptr);
+					continue;
+				}
+
+				if (c == '{' || c == '[') depth++;
+				if (c == '}' || c == ']') depth--;
+
+				pos++;
+			} while (depth != 0);
+		}
+
+		//insertion sort of the key and value pairs, literals are small
+		inline static constexpr void sortMembers(StaticNode* members, std::uint32_t count, const char* chars)
+		{
+			auto key = [&](std::uint32_t i)
+			{
+				return std::string_view(chars + members[2 * i].offset, members[2 * i].count);
+			};
+
+			for (std::uint32_t i = 1; i < count; i++)
+			{
+				for (std::uint32_t j = i; j > 0 && key(j) <= key(j - 1); j--)
+				{
+					if (key(j) == key(j - 1)) staticJsonIsMalformed("Dictionary has a duplicate key");
+
+					std::swap(members[2 * j], members[2 * (j - 1)]);
+					std::swap(members[2 * j + 1], members[2 * (j - 1) + 1]);
+				}
+			}
+		}
+
+		inline constexpr void skipWhitespace()
+		{
+			while (pos < source.size() && (source[pos] == ' ' || source[pos] == '\t' || source[pos] == '\n' || source[pos] == '\r')) pos++;
+		}
+
+		inline constexpr JsonValue::Type readKeyword()
+		{
+			std::string_view rest = source.substr(pos);
+
+			if (rest.starts_with("null"))
+			{
+				pos += 4;
+				return JsonValue::Type::Null;
+			}
+
+			if (rest.starts_with("true"))
+			{
+				pos += 4;
+				return JsonValue::Type::Boolean;
+			}
+
+			if (rest.starts_with("false"))
+			{
+				pos += 5;
+				return JsonValue::Type::Boolean;
+			}
+
+			staticJsonIsMalformed("Unknown token");
+		}
+
+		inline constexpr std::uint32_t readHex4()
+		{
+			if (pos + 4 > source.size()) staticJsonIsMalformed("Malformed escape in string");
+
+			std::uint32_t res = 0;
+
+			for (std::size_t end = pos + 4; pos < end; pos++)
+			{
+				char c = source[pos];
+				res <<= 4;
+
+				if (c >= '0' && c <= '9') res |= c - '0';
+				else if (c >= 'a' && c <= 'f') res |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F') res |= c - 'A' + 10;
+				else staticJsonIsMalformed("Malformed escape in string");
+			}
+
+			return res;
+		}
+
+		//decodes the string at pos into out when given, returns its length in bytes
+		inline constexpr std::size_t readString(char* out)
+		{
+			std::size_t length = 0;
+
+			auto put = [&](char c)
+			{
+				if (out) out[length] = c;
+				length++;
+			};
+
+			pos++;
+
+			while (true)
+			{
+				if (pos >= source.size()) staticJsonIsMalformed("Json string unexpectedly ended");
+
+				unsigned char c = (unsigned char)source[pos];
+
+				if (c == '"')
+				{
+					pos++;
+					return length;
+				}
+
+				if (c < 0x20) staticJsonIsMalformed("Control character in string");
+
+				if (c == '\\')
+				{
+					if (++pos >= source.size()) staticJsonIsMalformed("Malformed escape in string");
+
+					char escape = source[pos++];
+
+					switch (escape)
+					{
+					case '"': put('"'); break;
+					case '\\': put('\\'); break;
+					case '/': put('/'); break;
+					case 'b': put('\b'); break;
+					case 'f': put('\f'); break;
+					case 'n': put('\n'); break;
+					case 'r': put('\r'); break;
+					case 't': put('\t'); break;
+
+					case 'u':
+					{
+						std::uint32_t codepoint = readHex4();
+
+						if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) staticJsonIsMalformed("Malformed escape in string");
+
+						if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+						{
+							if (!source.substr(pos).starts_with("\\u")) staticJsonIsMalformed("Malformed escape in string");
+
+							pos += 2;
+							std::uint32_t low = readHex4();
+
+							if (low < 0xDC00 || low > 0xDFFF) staticJsonIsMalformed("Malformed escape in string");
+
+							codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+						}
+
+						if (codepoint < 0x80)
+						{
+							put((char)codepoint);
+						}
+						else if (codepoint < 0x800)
+						{
+							put((char)(0xC0 | (codepoint >> 6)));
+							put((char)(0x80 | (codepoint & 0x3F)));
+						}
+						else if (codepoint < 0x10000)
+						{
+							put((char)(0xE0 | (codepoint >> 12)));
+							put((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+							put((char)(0x80 | (codepoint & 0x3F)));
+						}
+						else
+						{
+							put((char)(0xF0 | (codepoint >> 18)));
+							put((char)(0x80 | ((codepoint >> 12) & 0x3F)));
+							put((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+							put((char)(0x80 | (codepoint & 0x3F)));
+						}
+						break;
+					}
+
+					default:
+						staticJsonIsMalformed("Malformed escape in string");
+					}
+
+					continue;
+				}
+
+				//same UTF-8 rules as unescapeString, no overlong forms, surrogates or code points above U+10FFFF
+				std::size_t sequence = 1;
+				unsigned char min = 0x80, max = 0xBF;
+
+				if (c >= 0xC2 && c <= 0xDF)
+				{
+					sequence = 2;
+				}
+				else if (c >= 0xE0 && c <= 0xEF)
+				{
+					sequence = 3;
+
+					if (c == 0xE0) min = 0xA0;
+					if (c == 0xED) max = 0x9F;
+				}
+				else if (c >= 0xF0 && c <= 0xF4)
+				{
+					sequence = 4;
+
+					if (c == 0xF0) min = 0x90;
+					if (c == 0xF4) max = 0x8F;
+				}
+				else if (c >= 0x80)
+				{
+					staticJsonIsMalformed("Invalid UTF-8 in string");
+				}
+
+				if (pos + sequence > source.size()) staticJsonIsMalformed("Invalid UTF-8 in string");
+
+				for (std::size_t i = 1; i < sequence; i++)
+				{
+					unsigned char next = (unsigned char)source[pos + i];
+
+					if (next < (i == 1 ? min : 0x80) || next > (i == 1 ? max : 0xBF)) staticJsonIsMalformed("Invalid UTF-8 in string");
+				}
+
+				for (std::size_t i = 0; i < sequence; i++)
+					put(source[pos++]);
+			}
+		}
+
+		//correctly rounded, so a literal holds the same double StringReader reads from the same text
+		inline constexpr double readNumber(bool convert)
+		{
+			constexpr double powers[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+			};
+
+			//more digits than this cannot change how a double rounds, as long as the dropped ones still count as nonzero
+			constexpr std::size_t maxDigits = 780;
+
+			auto isDigit = [&]()
+			{
+				return pos < source.size() && source[pos] >= '0' && source[pos] <= '9';
+			};
+
+			bool negative = pos < source.size() && source[pos] == '-';
+			if (negative) pos++;
+
+			//the number is digits as an integer times 10 to the exponent, leading zeros are not kept
+			char digits[maxDigits + 1] = {};
+			std::size_t count = 0;
+			long long exponent = 0;
+			bool truncated = false;
+
+			auto readDigits = [&](bool fraction)
+			{
+				if (!isDigit()) staticJsonIsMalformed("Number is malformed");
+
+				for (; isDigit(); pos++)
+				{
+					if (count == 0 && source[pos] == '0')
+					{
+						if (fraction) exponent--;
+					}
+					else if (count < maxDigits)
+					{
+						digits[count++] = source[pos];
+						if (fraction) exponent--;
+					}
+					else
+					{
+						if (source[pos] != '0') truncated = true;
+						if (!fraction) exponent++;
+					}
+				}
+			};
+
+			if (pos < source.size() && source[pos] == '0')
+			{
+				pos++;
+
+				if (isDigit()) staticJsonIsMalformed("Number is malformed");
+			}
+			else
+			{
+				readDigits(false);
+			}
+
+			if (pos < source.size() && source[pos] == '.')
+			{
+				pos++;
+				readDigits(true);
+			}
+
+			if (pos < source.size() && (source[pos] == 'e' || source[pos] == 'E'))
+			{
+				pos++;
+
+				bool negativeExponent = pos < source.size() && source[pos] == '-';
+				if (pos < source.size() && (source[pos] == '-' || source[pos] == '+')) pos++;
+
+				if (!isDigit()) staticJsonIsMalformed("Number is malformed");
+
+				long long explicitExponent = 0;
+
+				for (; isDigit(); pos++)
+				{
+					if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (source[pos] - '0');
+				}
+
+				exponent += negativeExponent ? -explicitExponent : explicitExponent;
+			}
+
+			//a trailing 1 stands in for the dropped digits, it sits strictly between the neighbours they could round to
+			if (truncated)
+			{
+				digits[count++] = '1';
+				exponent--;
+			}
+
+			for (; count > 0 && digits[count - 1] == '0'; count--)
+				exponent++;
+
+			double res = 0;
+
+			if (count > 0)
+			{
+				//the number is at least 10 to the magnitude - 1, anything outside these bounds overflows or rounds to zero
+				long long magnitude = (long long)count + exponent;
+
+				if (magnitude > 310 || magnitude < -323) staticJsonIsMalformed("Number is out of range");
+
+				std::uint64_t mantissa = 0;
+
+				for (std::size_t i = 0; i < count && i < 19; i++)
+					mantissa = mantissa * 10 + (digits[i] - '0');
+
+				//a few powers of ten past 1e22 can move into a small mantissa without rounding it
+				long long scale = exponent;
+
+				for (; count <= 19 && scale > 22 && mantissa <= (std::uint64_t(1) << 53) / 10; scale--)
+					mantissa *= 10;
+
+				//both operands are exact, so the one rounding step is correct
+				if (count <= 19 && mantissa <= (std::uint64_t(1) << 53) && scale >= -22 && scale <= 22)
+					res = scale >= 0 ? (double)mantissa * powers[scale] : (double)mantissa / powers[-scale];
+				else if (convert)
+					res = exactNumber(digits, count, exponent);
+			}
+
+			return negative ? -res : res;
+		}
+
+		//divides digits * 10^exponent by a power of two into 53 bits and rounds the rest half to even
+		static inline constexpr double exactNumber(const char* digits, std::size_t count, long long exponent)
+		{
+			StaticBigInt numerator;
+			StaticBigInt denominator(1);
+
+			for (std::size_t i = 0; i < count; i++)
+				numerator.multiplyAdd(10, digits[i] - '0');
+
+			if (exponent >= 0)
+				numerator.multiplyPow10((std::size_t)exponent);
+			else
+				denominator.multiplyPow10((std::size_t)-exponent);
+
+			//the quotient is numerator / denominator / 2^binary, the bit lengths put it between 2^52 and 2^54 unless it is subnormal
+			long long binary = std::max<long long>((long long)numerator.bitLength() - (long long)denominator.bitLength() - 53, -1074);
+
+			StaticBigInt remainder = binary < 0 ? numerator.shifted((std::size_t)-binary) : numerator;
+			StaticBigInt divisor = binary > 0 ? denominator.shifted((std::size_t)binary) : denominator;
+			StaticBigInt step = divisor.shifted(54);
+			std::uint64_t quotient = 0;
+
+			for (int bit = 54; bit >= 0; bit--)
+			{
+				if (remainder.compare(step) >= 0)
+				{
+					remainder.subtract(step);
+					quotient |= std::uint64_t(1) << bit;
+				}
+
+				step.halve();
+			}
+
+			//how the remainder compares to half of the divisor
+			int half = remainder.shifted(1).compare(divisor);
+
+			//one bit too many, it becomes the half and the remainder only says whether there was more
+			if (quotient >= std::uint64_t(1) << 53)
+			{
+				half = (quotient & 1) == 0 ? -1 : remainder.bitLength() == 0 ? 0 : 1;
+				quotient >>= 1;
+				binary++;
+			}
+
+			if (half > 0 || (half == 0 && (quotient & 1)))
+				quotient++;
+
+			if (quotient == std::uint64_t(1) << 53)
+			{
+				quotient >>= 1;
+				binary++;
+			}
+
+			if (quotient == 0 || binary + 1075 >= 2047) staticJsonIsMalformed("Number is out of range");
+
+			//subnormals have a biased exponent of 0 and no implicit bit
+			std::uint64_t bits = quotient < std::uint64_t(1) << 52 ? quotient : (std::uint64_t)(binary + 1075) << 52 | (quotient & ((std::uint64_t(1) << 52) - 1));
+
+			return std::bit_cast<double>(bits);
+		}
+
+		std::string_view source;
+		std::size_t pos;
+	};
+
+	namespace Literals
+	{
+		//R"({"retries": 3})"_json is parsed while compiling, malformed text does not compile
+		//keep the result in a static constexpr variable so it lives in read-only data
+		template<FixedString Text>
+		inline consteval auto operator""_json()
+		{
+			constexpr StaticParser::Size size = StaticParser(Text.view()).measure();
+
+			return StaticParser(Text.view()).build<size.nodes, size.chars>();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "Generator.h"
+#include "JsonValue.h"
+#include "StringReader.h"
+
+namespace Jsonify
+{
+	//reads a stream of json values one after another, separated by whitespace as in NDJSON or simply concatenated
+	//input is taken in chunks and each value is yielded as soon as it is complete, only the value being parsed is held in memory
+	class StreamReader
+	{
+	public:
+		struct Settings
+		{
+			StringReader::Settings reader;
+
+			//most bytes taken from the stream at a time, whatever it already holds is taken without waiting
+			//once it holds nothing the reader waits for a whole chunk or the end of the stream, lower this for a slow source whose values have to be seen as soon as they arrive
+			std::size_t chunkSize = 64 * 1024;
+
+			//a value that grows past this is rejected instead of being buffered
+			std::size_t maxValueSize = std::numeric_limits<std::size_t>::max();
+		};
+
+		StreamReader();
+		StreamReader(Settings settings);
+
+		//yields each value as soon as it is complete, malformed input throws out of the loop reading it
+		//the value yielded is parsed over in place by the next one, move it out to keep it
+		//the reader and in have to outlive the generator, any number of generators can read from one reader at once
+		Generator<JsonValue> read(std::istream& in);
+
+	private:
+		Settings settings;
+	};
+}
\ No newline at end of file
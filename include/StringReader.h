@@ -1,25 +1,89 @@
 #pragma once
 
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Lexer.h"
 #include "JsonValue.h"
+#include "ParseError.h"
+#include "Schema.h"
 
 namespace Jsonify
 {
+	//keeps its scratch buffers between reads, reuse one instance to avoid reallocating them
 	class StringReader
 	{
 	public:
+		struct Settings
+		{
+			//deeper nesting is rejected before it is parsed
+			std::size_t maxDepth = 512;
+
+			//arrays that start with a number are read into a packed buffer, see JsonValue::isPacked
+			bool packNumbers = false;
+
+			//numbers keep the text they were read from, see JsonValue::isRawNumber, and arrays are not packed
+			bool rawNumbers = false;
+
+			//reads parse over the value they are given, reusing the arrays, dictionaries and strings it already holds
+			//a failed read then leaves it null, otherwise it is only replaced once the whole input has parsed
+			bool inPlace = false;
+
+			//checked while parsing, the first value that breaks it fails the read, has to outlive the reader
+			const Schema* schema = nullptr;
+		};
+
 		StringReader();
+		StringReader(Settings settings);
+
+		//the lexer and scratch buffers are kept between reads, see Settings::inPlace for reusing value's storage as well
+		void read(std::string_view in, JsonValue& value);
 
-		void read(const std::string& in, JsonValue& value);
+		//value is left as it was on failure, unless reading in place
+		bool tryRead(std::string_view in, JsonValue& value, ParseError& error);
+
+		//the checks of a read with the same settings without building or allocating anything, only the schema is not applied
+		bool validate(std::string_view in);
+		bool validate(std::string_view in, ParseError& error);
 
 	private:
-		JsonValue parseValue(Lexer& lexer);
-		JsonValue parseKeyword(Lexer& lexer);
-		JsonValue parseString(Lexer& lexer);
-		JsonValue parseNumber(Lexer& lexer);
-		JsonValue parseArray(Lexer& lexer);
-		JsonValue parseDictionary(Lexer& lexer);
+		struct Frame
+		{
+			JsonValue* container;
+			std::size_t count;
+
+			//entries the dictionary held before this read, taken back by key as they are parsed again
+			JsonValue::Map recycled;
+			std::pmr::string key;
+		};
+
+		bool parseDocument(std::string_view in, JsonValue& value, ParseError& error);
+		bool parseValue(JsonValue& value, ParseError& error);
+		bool parseKeyword(JsonValue& value, const Token& tok, ParseError& error);
+		bool parseString(JsonValue& value, const Token& tok, ParseError& error);
+		bool parseNumber(JsonValue& value, const Token& tok, ParseError& error);
+		bool parseNumber(double& num, const Token& tok, ParseError& error);
+		bool parseKey(std::pmr::string& key, const Token& tok, ParseError& error);
+
+		bool validateValue(ParseError& error);
+		bool checkString(const Token& tok, ParseError& error);
+
+		void openContainer(JsonValue& container, bool isArray, std::size_t depth);
+		void closeContainer(Frame& frame);
+		JsonValue& nextElement(Frame& frame);
+		JsonValue& nextMember(Frame& frame);
+
+		Settings settings;
+
+		Lexer lexer;
+		std::vector<Frame> stack;
+
+		std::optional<SchemaValidator> validator;
+
+		//containers open while walking the input, true for arrays
+		std::vector<bool> open;
 	};
-}
+}
\ No newline at end of file
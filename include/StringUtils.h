@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace Jsonify
+{
+	//offset of the quote closing a string whose content starts at start, npos if the string is unterminated or holds a control character
+	std::size_t findStringEnd(std::string_view source, std::size_t start);
+
+	//appends the decoded form of the content between two quotes, returns false on a bad escape or invalid UTF-8
+	bool unescapeString(std::string_view raw, std::string& out);
+	bool unescapeString(std::string_view raw, std::pmr::string& out);
+
+	//same checks as unescapeString without producing any output
+	bool validateString(std::string_view raw);
+
+	//whether raw decodes to exactly str, without building the decoded string
+	bool unescapedEquals(std::string_view raw, std::string_view str);
+
+	//appends str with quotes, backslashes and control characters escaped, without the surrounding quotes
+	void escapeString(std::string_view str, std::string& out);
+
+	//writes exactly escapedLength(str) bytes to out and returns the end of them
+	char* escapeString(std::string_view str, char* out);
+	std::size_t escapedLength(std::string_view str);
+
+	bool isValidUtf8(std::string_view str);
+
+	//the json number grammar exactly, which is stricter than what from_chars accepts
+	bool isNumberLiteral(std::string_view str);
+
+	//converts a valid number literal, out of range values are rounded to infinity or zero as strtod does
+	double numberFromLiteral(std::string_view str);
+
+	std::size_t countNewlines(std::string_view str);
+}
\ No newline at end of file
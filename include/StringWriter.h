@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
+#include "Lexer.h"
 #include "JsonValue.h"
+#include "ParseError.h"
 
 namespace Jsonify
 {
@@ -12,14 +17,46 @@ namespace Jsonify
 		struct Settings
 		{
 			bool pretty = false;
+
+			//written once per level of nesting when pretty
+			std::string indent = "   ";
+
+			//transcoding only, strings and numbers are rewritten the way write would instead of copied
+			bool normalize = false;
+
+			//transcoding only
+			std::size_t maxDepth = 512;
+
+			//RFC 8785 output for write, measure and hash: keys sorted by UTF-16 code units, numbers formatted the way ECMAScript does and no whitespace
+			//pretty is ignored, and NaN or infinity throws since the form has nothing for them
+			bool canonical = false;
 		};
 
 		StringWriter(Settings settings);
 
-		void write(JsonValue& value, std::string& out);
+		//sizes the output once and fills it in place
+		void write(const JsonValue& value, std::string& out) const;
+
+		//exact number of bytes written for value
+		std::size_t measure(const JsonValue& value) const;
+
+		//writes exactly measure(value) bytes without bounds checks, returns the end of them
+		char* write(const JsonValue& value, char* out) const;
+
+		//XXH64 of exactly the bytes write would produce, computed as they are generated so the text never exists
+		//with canonical set, documents that are equal hash equally whatever order their keys were inserted in
+		std::uint64_t hash(const JsonValue& value) const;
+
+		//reformats json text token by token without building a JsonValue, so key order is kept
+		//appends to out, which is left as it was if in is malformed
+		void transcode(std::string_view in, std::string& out) const;
+		bool tryTranscode(std::string_view in, std::string& out, ParseError& error) const;
 
 	private:
-		void write(JsonValue& value, std::string& out, int indents);
+		template<typename Sink>
+		void write(const JsonValue& root, Sink& sink) const;
+
+		bool transcode(Lexer& lexer, std::string& out, ParseError& error) const;
 
 		Settings settings;
 	};
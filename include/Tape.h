@@ -0,0 +1,100 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "JsonValue.h"
+#include "ParseError.h"
+
+namespace Jsonify
+{
+	struct TapeEntry
+	{
+		enum class Type : std::uint8_t
+		{
+			ArrayStart,
+			ArrayEnd,
+			DictionaryStart,
+			DictionaryEnd,
+			String,
+			Number,
+			Boolean,
+			Null,
+		};
+
+		Type type;
+
+		//strings containing a backslash have to be unescaped before use
+		bool escaped;
+
+		//raw token in the source, for strings the content between the quotes
+		std::uint32_t offset;
+
+		union
+		{
+			//scalars
+			std::uint32_t length;
+
+			//container starts, number of direct children
+			std::uint32_t count;
+		};
+
+		//container starts hold the index of their end, ends hold the index of their start
+		std::uint32_t link;
+	};
+
+	//the whole document as one flat array, keys are stored as a String entry right before their value
+	class Tape
+	{
+	public:
+		static constexpr std::size_t npos = (std::size_t)-1;
+
+		struct Settings
+		{
+			std::size_t maxDepth = 512;
+		};
+
+		Tape();
+		Tape(Settings settings);
+
+		//entries point into source, which has to outlive the tape
+		void build(std::string_view source);
+		bool tryBuild(std::string_view source, ParseError& error);
+
+		//a string that is about to be destroyed would leave the tape pointing into freed memory
+		template<typename T> requires std::same_as<std::remove_const_t<T>, std::string>
+		void build(T&& source) = delete;
+
+		template<typename T> requires std::same_as<std::remove_const_t<T>, std::string>
+		bool tryBuild(T&& source, ParseError& error) = delete;
+
+		const std::vector<TapeEntry>& getEntries() const;
+		const TapeEntry& operator[](std::size_t index) const;
+
+		//index just past the value at index, whole containers are skipped in O(1)
+		std::size_t skip(std::size_t index) const;
+		std::size_t size(std::size_t index) const;
+
+		//index of the value, or npos
+		std::size_t find(std::size_t dictionary, std::string_view key) const;
+		std::size_t at(std::size_t array, std::size_t n) const;
+
+		std::string_view getRaw(std::size_t index) const;
+		std::string getString(std::size_t index) const;
+		double getNumber(std::size_t index) const;
+		bool getBoolean(std::size_t index) const;
+
+		void toValue(std::size_t index, JsonValue& value) const;
+
+	private:
+		std::vector<TapeEntry> entries;
+		std::string_view source;
+
+		Settings settings;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,515 @@
+#include "ColumnReader.h"
+
+#include <charconv>
+#include <cmath>
+#include <format>
+
+#include "Grammar.h"
+#include "StringUtils.h"
+
+namespace Jsonify
+{
+	namespace
+	{
+		//appends a null row, the reader fills it in when the key turns up
+		void beginRow(Column& column)
+		{
+			switch (column.type)
+			{
+			case Column::Type::Number:
+				column.numbers.push_back(0);
+				break;
+
+			case Column::Type::Integer:
+				column.integers.push_back(0);
+				break;
+
+			case Column::Type::String:
+				column.codes.push_back(0);
+				break;
+
+			case Column::Type::Boolean:
+				column.booleans.push_back(0);
+				break;
+			}
+
+			if (column.rows % 64 == 0) column.validity.push_back(0);
+
+			column.rows++;
+		}
+
+		void setValid(Column& column, bool valid)
+		{
+			std::size_t row = column.rows - 1;
+			std::uint64_t bit = (std::uint64_t)1 << (row % 64);
+
+			if (valid)
+				column.validity[row / 64] |= bit;
+			else
+				column.validity[row / 64] &= ~bit;
+		}
+
+		//a repeated key can null a row that already had a value
+		void setNull(Column& column)
+		{
+			switch (column.type)
+			{
+			case Column::Type::Number:
+				column.numbers.back() = 0;
+				break;
+
+			case Column::Type::Integer:
+				column.integers.back() = 0;
+				break;
+
+			case Column::Type::String:
+				column.codes.back() = 0;
+				break;
+
+			case Column::Type::Boolean:
+				column.booleans.back() = 0;
+				break;
+			}
+
+			setValid(column, false);
+		}
+
+		//integral values written with a fraction or exponent are accepted as long as they fit
+		bool toInteger(double num, std::int64_t& res)
+		{
+			if (num != std::trunc(num) || num < -9223372036854775808.0 || num >= 9223372036854775808.0) return false;
+
+			res = (std::int64_t)num;
+
+			return true;
+		}
+	}
+
+	Column::Column(std::string key, Type type)
+		: key(std::move(key)), type(type)
+	{
+	}
+
+	bool Column::isValid(std::size_t row) const
+	{
+		return (validity[row / 64] >> (row % 64)) & 1;
+	}
+
+	std::string_view Column::getString(std::size_t row) const
+	{
+		if (type != Type::String) throw std::runtime_error("Column does not hold strings");
+
+		return isValid(row) ? std::string_view(dictionary[codes[row]]) : std::string_view();
+	}
+
+	void Column::clear()
+	{
+		rows = 0;
+
+		numbers.clear();
+		integers.clear();
+		booleans.clear();
+		codes.clear();
+		dictionary.clear();
+		validity.clear();
+	}
+
+	ColumnReader::ColumnReader()
+		: settings()
+	{
+	}
+
+	ColumnReader::ColumnReader(Settings settings)
+		: settings(settings)
+	{
+	}
+
+	void ColumnReader::read(std::string_view in, std::vector<Column>& columns)
+	{
+		ParseError error;
+
+		if (!tryRead(in, columns, error))
+			throw std::runtime_error(error.message());
+	}
+
+	bool ColumnReader::tryRead(std::string_view in, std::vector<Column>& columns, ParseError& error)
+	{
+		reset(columns);
+
+		lexer.reset(in);
+		lexer.nextToken();
+
+		bool read = readRows(columns, error);
+
+		if (read && !lexer.isEnd())
+			read = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
+
+		if (!read)
+		{
+			reset(columns);
+			error.locate(in);
+
+			return false;
+		}
+
+		error = ParseError();
+
+		return true;
+	}
+
+	void ColumnReader::readValue(const JsonValue& rows, std::vector<Column>& columns)
+	{
+		if (rows.type != JsonValue::Type::Array) throw std::runtime_error("Type is not an array");
+
+		reset(columns);
+
+		//a packed array only holds numbers, so any row it has is not a dictionary
+		if (rows.packed)
+		{
+			if (!rows.p.values.empty()) throw std::runtime_error("Row 0 is not a dictionary");
+
+			return;
+		}
+
+		const std::pmr::vector<JsonValue>& elements = rows.v;
+
+		std::vector<JsonValue::Key> keys;
+		keys.reserve(columns.size());
+
+		for (const Column& column : columns)
+			keys.emplace_back(column.key);
+
+		for (std::size_t i = 0; i < elements.size(); i++)
+		{
+			const JsonValue& row = elements[i];
+
+			if (row.type != JsonValue::Type::Dictionary) throw std::runtime_error(std::format("Row {} is not a dictionary", i));
+
+			for (std::size_t c = 0; c < columns.size(); c++)
+			{
+				Column& column = columns[c];
+				beginRow(column);
+
+				auto it = row.m.find(keys[c]);
+				if (it == row.m.end() || it->second.type == JsonValue::Type::Null) continue;
+
+				const JsonValue& value = it->second;
+				bool matches = true;
+
+				switch (column.type)
+				{
+				case Column::Type::Number:
+					matches = value.type == JsonValue::Type::Number;
+					if (matches) column.numbers.back() = value.number();
+					break;
+
+				case Column::Type::Integer:
+					matches = value.type == JsonValue::Type::Number;
+
+					//raw numbers are read from their text so integers past 2^53 stay exact
+					if (matches && value.rawNumber)
+					{
+						try
+						{
+							column.integers.back() = value.integer<std::int64_t>();
+						}
+						catch (const std::runtime_error&)
+						{
+							matches = false;
+						}
+					}
+					else if (matches)
+					{
+						matches = toInteger(value.number(), column.integers.back());
+					}
+					break;
+
+				case Column::Type::String:
+					matches = value.type == JsonValue::Type::String;
+					if (matches) setString(column, stringCodes[c], value.s);
+					break;
+
+				case Column::Type::Boolean:
+					matches = value.type == JsonValue::Type::Boolean;
+					if (matches) column.booleans.back() = value.b;
+					break;
+				}
+
+				if (!matches) throw std::runtime_error(std::format("Value of {} in row {} does not match the column's type", column.key, i));
+
+				setValid(column, true);
+			}
+		}
+	}
+
+	bool ColumnReader::readRows(std::vector<Column>& columns, ParseError& error)
+	{
+		const Token& tok = lexer.readToken();
+
+		if (tok.type == Token::Type::Eof) return error.fail(ParseError::Kind::UnexpectedEnd, tok);
+		if (!tok.isChar('[')) return error.fail(ParseError::Kind::UnexpectedType, tok);
+
+		if (lexer.nextToken().isChar(']'))
+		{
+			lexer.nextToken();
+			return true;
+		}
+
+		while (true)
+		{
+			if (!readRow(columns, error)) return false;
+
+			if (lexer.readToken().isChar(','))
+			{
+				lexer.nextToken();
+				continue;
+			}
+
+			if (lexer.readToken().isChar(']'))
+			{
+				lexer.nextToken();
+				return true;
+			}
+
+			return error.fail(lexer.isEnd() ? ParseError::Kind::UnexpectedEnd : ParseError::Kind::MissingArrayEnd, lexer.readToken());
+		}
+	}
+
+	bool ColumnReader::readRow(std::vector<Column>& columns, ParseError& error)
+	{
+		const Token& tok = lexer.readToken();
+
+		if (tok.type == Token::Type::Eof) return error.fail(ParseError::Kind::UnexpectedEnd, tok);
+		if (!tok.isChar('{')) return error.fail(ParseError::Kind::UnexpectedType, tok);
+
+		for (Column& column : columns)
+			beginRow(column);
+
+		if (lexer.nextToken().isChar('}'))
+		{
+			lexer.nextToken();
+			return true;
+		}
+
+		while (true)
+		{
+			if (!readKey(error)) return false;
+
+			//a handful of columns is searched faster in order than through a table
+			std::size_t c = 0;
+			while (c < columns.size() && columns[c].key != key) c++;
+
+			if (c < columns.size())
+			{
+				if (!readField(columns[c], stringCodes[c], error)) return false;
+			}
+			else
+			{
+				if (!skipValue(error)) return false;
+			}
+
+			if (lexer.readToken().isChar(','))
+			{
+				lexer.nextToken();
+				continue;
+			}
+
+			if (lexer.readToken().isChar('}'))
+			{
+				lexer.nextToken();
+				return true;
+			}
+
+			return error.fail(lexer.isEnd() ? ParseError::Kind::UnexpectedEnd : ParseError::Kind::MissingDictionaryEnd, lexer.readToken());
+		}
+	}
+
+	//a repeated key overwrites the value read first
+	bool ColumnReader::readField(Column& column, StringCodes& codes, ParseError& error)
+	{
+		const Token& tok = lexer.readToken();
+
+		if (tok.type == Token::Type::Null)
+		{
+			setNull(column);
+			lexer.nextToken();
+
+			return true;
+		}
+
+		switch (column.type)
+		{
+		case Column::Type::Number:
+		case Column::Type::Integer:
+		{
+			if (tok.type != Token::Type::Number) break;
+
+			if (!isNumberLiteral(tok.rawValue))
+				return error.fail(ParseError::Kind::MalformedNumber, tok);
+
+			if (column.type == Column::Type::Integer)
+			{
+				std::string_view raw = tok.rawValue;
+				auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), column.integers.back());
+
+				//a valid number that no int64 holds is a mismatch like any other, as it is when reading a JsonValue
+				if (ec == std::errc::result_out_of_range)
+					return error.fail(ParseError::Kind::UnexpectedType, tok);
+
+				if (ec == std::errc() && end == raw.data() + raw.size())
+				{
+					setValid(column, true);
+					lexer.nextToken();
+
+					return true;
+				}
+			}
+
+			double num;
+
+			if (!toNumber(tok, num, error)) return false;
+
+			if (column.type == Column::Type::Number)
+				column.numbers.back() = num;
+			else if (!toInteger(num, column.integers.back()))
+				return error.fail(ParseError::Kind::UnexpectedType, tok);
+
+			setValid(column, true);
+			lexer.nextToken();
+
+			return true;
+		}
+
+		case Column::Type::String:
+		{
+			if (tok.type != Token::Type::String) break;
+
+			std::string_view str = tok.rawValue;
+
+			if (str.find('\\') != std::string_view::npos)
+			{
+				unescaped.clear();
+
+				if (!unescapeString(tok.rawValue, unescaped))
+					return error.fail(ParseError::Kind::MalformedString, tok);
+
+				str = unescaped;
+			}
+			else if (!isValidUtf8(str))
+			{
+				return error.fail(ParseError::Kind::MalformedString, tok);
+			}
+
+			setString(column, codes, str);
+			setValid(column, true);
+			lexer.nextToken();
+
+			return true;
+		}
+
+		case Column::Type::Boolean:
+			if (tok.type != Token::Type::Boolean) break;
+
+			column.booleans.back() = tok.rawValue == "true";
+			setValid(column, true);
+			lexer.nextToken();
+
+			return true;
+		}
+
+		if (tok.type == Token::Type::Eof) return error.fail(ParseError::Kind::UnexpectedEnd, tok);
+
+		return error.fail(ParseError::Kind::UnexpectedType, tok);
+	}
+
+	//leaves key pointing into the input unless it had escapes
+	bool ColumnReader::readKey(ParseError& error)
+	{
+		const Token& tokKey = lexer.readToken();
+
+		if (tokKey.type != Token::Type::String)
+			return error.fail(ParseError::Kind::MalformedKey, tokKey);
+
+		key = tokKey.rawValue;
+
+		if (key.find('\\') != std::string_view::npos)
+		{
+			unescaped.clear();
+
+			if (!unescapeString(tokKey.rawValue, unescaped))
+				return error.fail(ParseError::Kind::MalformedString, tokKey);
+
+			key = unescaped;
+		}
+		else if (!isValidUtf8(key))
+		{
+			return error.fail(ParseError::Kind::MalformedString, tokKey);
+		}
+
+		if (!lexer.nextToken().isChar(':'))
+			return error.fail(ParseError::Kind::ExpectedColon, lexer.readToken());
+
+		lexer.nextToken();
+
+		return true;
+	}
+
+	//consumes one value without keeping it, with the same checks StringReader makes
+	bool ColumnReader::skipValue(ParseError& error)
+	{
+		struct Skipper
+		{
+			bool scalar(const Token& tok, ParseError& error)
+			{
+				double num;
+
+				if (tok.type == Token::Type::Number) return toNumber(tok, num, error);
+
+				return tok.type != Token::Type::String || validateString(tok.rawValue) || error.fail(ParseError::Kind::MalformedString, tok);
+			}
+
+			bool key(const Token& tok, ParseError& error)
+			{
+				return validateString(tok.rawValue) || error.fail(ParseError::Kind::MalformedString, tok);
+			}
+
+			bool beginContainer(bool, const Token&, ParseError&)
+			{
+				return true;
+			}
+
+			bool endContainer(bool, const Token&, ParseError&)
+			{
+				return true;
+			}
+		};
+
+		Skipper skipper;
+
+		return walkValue(lexer, skipper, skipped, settings.maxDepth, error);
+	}
+
+	void ColumnReader::reset(std::vector<Column>& columns)
+	{
+		for (Column& column : columns)
+			column.clear();
+
+		stringCodes.resize(columns.size());
+
+		for (StringCodes& codes : stringCodes)
+			codes.clear();
+	}
+
+	void ColumnReader::setString(Column& column, StringCodes& codes, std::string_view str)
+	{
+		auto it = codes.find(str);
+
+		if (it == codes.end())
+		{
+			it = codes.try_emplace(std::string(str), (std::uint32_t)column.dictionary.size()).first;
+			column.dictionary.emplace_back(str);
+		}
+
+		column.codes.back() = it->second;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "FrozenDocument.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "StringUtils.h"
+
+namespace Jsonify
+{
+	namespace
+	{
+		constexpr std::size_t npos = (std::size_t)-1;
+
+		std::uint32_t hashKey(std::string_view key)
+		{
+			return (std::uint32_t)std::hash<std::string_view>()(key);
+		}
+
+		std::size_t slotCount(std::size_t members)
+		{
+			return members == 0 ? 0 : std::bit_ceil(2 * members);
+		}
+
+		struct Member
+		{
+			std::string_view key;
+			const JsonValue* value;
+
+			bool operator<(const Member& other) const
+			{
+				return key < other.key;
+			}
+		};
+	}
+
+	FrozenDocument::FrozenDocument(const JsonValue& value)
+	{
+		//breadth first so the children of every container end up next to each other
+		std::vector<FrozenNode> nodes(1);
+		std::vector<const JsonValue*> sources = { &value };
+		std::vector<std::uint32_t> slots;
+		std::vector<Member> members;
+		std::string chars;
+
+		auto pushString = [&](std::string_view str, std::uint32_t hash)
+		{
+			FrozenNode node{};
+			node.type = JsonValue::Type::String;
+			node.count = (std::uint32_t)str.size();
+			node.string = { (std::uint32_t)chars.size(), hash };
+
+			chars.append(str);
+
+			return node;
+		};
+
+		for (std::size_t i = 0; i < nodes.size(); i++)
+		{
+			//keys and elements of packed arrays are complete when they are pushed
+			if (!sources[i]) continue;
+
+			const JsonValue& source = *sources[i];
+			FrozenNode node{};
+			node.type = source.type;
+
+			switch (source.type)
+			{
+			case JsonValue::Type::String:
+				node = pushString(source.s, 0);
+				break;
+
+			case JsonValue::Type::Number:
+				if (source.rawNumber)
+				{
+					node.count = (std::uint32_t)source.s.size();
+					node.string = { (std::uint32_t)chars.size(), 0 };
+
+					chars.append(source.s);
+				}
+				else
+				{
+					node.number = source.n;
+				}
+				break;
+
+			case JsonValue::Type::Boolean:
+				node.boolean = source.b;
+				break;
+
+			case JsonValue::Type::Null:
+				break;
+
+			case JsonValue::Type::Array:
+				node.container = { (std::uint32_t)nodes.size(), 0 };
+
+				if (source.packed)
+				{
+					node.count = (std::uint32_t)source.p.values.size();
+
+					for (double num : source.p.values)
+					{
+						FrozenNode element{};
+						element.type = JsonValue::Type::Number;
+						element.number = num;
+
+						nodes.push_back(element);
+						sources.push_back(nullptr);
+					}
+				}
+				else
+				{
+					node.count = (std::uint32_t)source.v.size();
+
+					for (const JsonValue& element : source.v)
+					{
+						nodes.emplace_back();
+						sources.push_back(&element);
+					}
+				}
+				break;
+
+			case JsonValue::Type::Dictionary:
+			{
+				node.container = { (std::uint32_t)nodes.size(), (std::uint32_t)slots.size() };
+				node.count = (std::uint32_t)source.m.size();
+
+				members.clear();
+
+				for (const auto& [k, v] : source.m)
+					members.push_back({ k, &v });
+
+				std::sort(members.begin(), members.end());
+
+				std::size_t mask = slotCount(members.size()) - 1;
+				slots.resize(slots.size() + slotCount(members.size()));
+
+				std::uint32_t* table = slots.data() + node.container.slots;
+
+				for (std::size_t m = 0; m < members.size(); m++)
+				{
+					std::uint32_t hash = hashKey(members[m].key);
+
+					std::size_t slot = hash & mask;
+					while (table[slot] != 0) slot = (slot + 1) & mask;
+
+					table[slot] = (std::uint32_t)m + 1;
+
+					nodes.push_back(pushString(members[m].key, hash));
+					sources.push_back(nullptr);
+
+					nodes.emplace_back();
+					sources.push_back(members[m].value);
+				}
+				break;
+			}
+			}
+
+			nodes[i] = node;
+		}
+
+		if (nodes.size() > UINT32_MAX || slots.size() > UINT32_MAX || chars.size() > UINT32_MAX) throw std::runtime_error("Value is too large to freeze");
+
+		std::size_t nodeBytes = nodes.size() * sizeof(FrozenNode);
+		std::size_t slotBytes = slots.size() * sizeof(std::uint32_t);
+
+		size = nodeBytes + slotBytes + chars.size();
+		storage = std::make_unique<std::byte[]>(size);
+
+		std::memcpy(storage.get(), nodes.data(), nodeBytes);
+		std::memcpy(storage.get() + nodeBytes, slots.data(), slotBytes);
+		std::memcpy(storage.get() + nodeBytes + slotBytes, chars.data(), chars.size());
+
+		this->nodes = (const FrozenNode*)storage.get();
+		this->slots = (const std::uint32_t*)(storage.get() + nodeBytes);
+		this->chars = (const char*)(storage.get() + nodeBytes + slotBytes);
+	}
+
+	FrozenValue FrozenDocument::getRoot() const
+	{
+		return FrozenValue(this, 0);
+	}
+
+	std::size_t FrozenDocument::getSize() const
+	{
+		return size;
+	}
+
+	FrozenValue::FrozenValue(const FrozenDocument* document, std::uint32_t index)
+		: document(document), index(index)
+	{
+	}
+
+	const FrozenNode& FrozenValue::getNode() const
+	{
+		return document->nodes[index];
+	}
+
+	JsonValue::Type FrozenValue::getType() const
+	{
+		return getNode().type;
+	}
+
+	bool FrozenValue::isNull() const
+	{
+		return getNode().type == JsonValue::Type::Null;
+	}
+
+	std::size_t FrozenValue::size() const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Array && node.type != JsonValue::Type::Dictionary)
+			throw std::runtime_error("Unable to get size of a type that is not Dictionary or Array");
+
+		return node.count;
+	}
+
+	FrozenValue FrozenValue::operator[](std::string_view key) const
+	{
+		std::size_t member = findMember(key, hashKey(key));
+		if (member == npos) throw std::out_of_range("Key not found");
+
+		return FrozenValue(document, (std::uint32_t)member + 1);
+	}
+
+	FrozenValue FrozenValue::operator[](const JsonValue::Key& key) const
+	{
+		std::size_t member = findMember(key.name, (std::uint32_t)key.hash);
+		if (member == npos) throw std::out_of_range("Key not found");
+
+		return FrozenValue(document, (std::uint32_t)member + 1);
+	}
+
+	FrozenValue FrozenValue::operator[](std::size_t index) const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Array) throw std::runtime_error("Type is not an array");
+		if (index >= node.count) throw std::out_of_range("Array index out of range");
+
+		return FrozenValue(document, node.container.first + (std::uint32_t)index);
+	}
+
+	bool FrozenValue::contains(std::string_view key) const
+	{
+		return findMember(key, hashKey(key)) != npos;
+	}
+
+	bool FrozenValue::contains(const JsonValue::Key& key) const
+	{
+		return findMember(key.name, (std::uint32_t)key.hash) != npos;
+	}
+
+	std::string_view FrozenValue::getKey(std::size_t index) const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+		if (index >= node.count) throw std::out_of_range("Member index out of range");
+
+		return FrozenValue(document, node.container.first + 2 * (std::uint32_t)index).getString();
+	}
+
+	FrozenValue FrozenValue::getValue(std::size_t index) const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+		if (index >= node.count) throw std::out_of_range("Member index out of range");
+
+		return FrozenValue(document, node.container.first + 2 * (std::uint32_t)index + 1);
+	}
+
+	std::string_view FrozenValue::getString() const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::String) throw std::runtime_error("Type is not a string");
+
+		return std::string_view(document->chars + node.string.offset, node.count);
+	}
+
+	double FrozenValue::getNumber() const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Number) throw std::runtime_error("Type is not a number");
+
+		if (node.count != 0) return numberFromLiteral(getRawNumber());
+
+		return node.number;
+	}
+
+	bool FrozenValue::isRawNumber() const
+	{
+		const FrozenNode& node = getNode();
+
+		return node.type == JsonValue::Type::Number && node.count != 0;
+	}
+
+	std::string_view FrozenValue::getRawNumber() const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Number || node.count == 0) throw std::runtime_error("Type is not a raw number");
+
+		return std::string_view(document->chars + node.string.offset, node.count);
+	}
+
+	bool FrozenValue::getBoolean() const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Boolean) throw std::runtime_error("Type is not a boolean");
+
+		return node.boolean;
+	}
+
+	void FrozenValue::toValue(JsonValue& value) const
+	{
+		const FrozenNode& node = getNode();
+
+		value = JsonValue();
+
+		switch (node.type)
+		{
+		case JsonValue::Type::Null:
+			break;
+
+		case JsonValue::Type::Boolean:
+			value = node.boolean;
+			break;
+
+		case JsonValue::Type::Number:
+			if (node.count != 0)
+				value.setRawNumber(getRawNumber());
+			else
+				value = node.number;
+			break;
+
+		case JsonValue::Type::String:
+			value = std::string(getString());
+			break;
+
+		case JsonValue::Type::Array:
+			value.resize(node.count);
+
+			for (std::uint32_t i = 0; i < node.count; i++)
+				FrozenValue(document, node.container.first + i).toValue(value[i]);
+			break;
+
+		case JsonValue::Type::Dictionary:
+			value.setType(JsonValue::Type::Dictionary);
+
+			for (std::uint32_t i = 0; i < node.count; i++)
+			{
+				std::uint32_t key = node.container.first + 2 * i;
+
+				FrozenValue(document, key + 1).toValue(value[std::string(FrozenValue(document, key).getString())]);
+			}
+			break;
+		}
+	}
+
+	std::size_t FrozenValue::findMember(std::string_view key, std::uint32_t hash) const
+	{
+		const FrozenNode& node = getNode();
+
+		if (node.type != JsonValue::Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+		if (node.count == 0) return npos;
+
+		std::size_t mask = std::bit_ceil(2 * (std::size_t)node.count) - 1;
+		const std::uint32_t* table = document->slots + node.container.slots;
+		const FrozenNode* keys = document->nodes + node.container.first;
+
+		for (std::size_t slot = hash & mask; table[slot] != 0; slot = (slot + 1) & mask)
+		{
+			std::size_t member = 2 * (std::size_t)(table[slot] - 1);
+			const FrozenNode& candidate = keys[member];
+
+			if (candidate.string.hash == hash && std::string_view(document->chars + candidate.string.offset, candidate.count) == key)
+				return node.container.first + member;
+		}
+
+		return npos;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,514 @@
+#include "JsonPatch.h"
+
+#include <algorithm>
+#include <format>
+#include <string_view>
+#include <vector>
+
+namespace Jsonify
+{
+	namespace
+	{
+		typedef std::vector<std::string> Pointer;
+
+		struct UndoEntry
+		{
+			enum class Kind
+			{
+				Added,
+				Removed,
+				Replaced,
+				Moved,
+			};
+
+			Kind kind = Kind::Added;
+			Pointer path = {};
+			JsonValue value = {};
+
+			//only used by moves
+			Pointer from = {};
+			bool replaced = false;
+		};
+
+		Pointer parsePointer(const std::string& pointer)
+		{
+			Pointer res;
+
+			if (pointer.empty()) return res;
+			if (pointer[0] != '/') throw std::runtime_error(std::format("Json pointer \"{}\" does not start with '/'", pointer));
+
+			std::size_t start = 1;
+			while (true)
+			{
+				std::size_t end = pointer.find('/', start);
+				if (end == std::string::npos) end = pointer.size();
+
+				std::string token;
+				for (std::size_t i = start; i < end; i++)
+				{
+					if (pointer[i] != '~')
+					{
+						token.push_back(pointer[i]);
+						continue;
+					}
+
+					if (i + 1 < end && pointer[i + 1] == '0') token.push_back('~');
+					else if (i + 1 < end && pointer[i + 1] == '1') token.push_back('/');
+					else throw std::runtime_error(std::format("Json pointer \"{}\" has a malformed escape", pointer));
+
+					i++;
+				}
+
+				res.push_back(std::move(token));
+
+				if (end == pointer.size()) break;
+				start = end + 1;
+			}
+
+			return res;
+		}
+
+		void appendPointerToken(std::string& path, std::string_view token)
+		{
+			path.push_back('/');
+
+			for (char c : token)
+			{
+				if (c == '~') path.append("~0");
+				else if (c == '/') path.append("~1");
+				else path.push_back(c);
+			}
+		}
+
+		//"-" is only accepted when appending
+		std::size_t parseIndex(const std::string& token, std::size_t size, bool allowEnd)
+		{
+			if (allowEnd && token == "-") return size;
+
+			if (token.empty() || (token.size() > 1 && token[0] == '0')) throw std::runtime_error(std::format("\"{}\" is not a valid array index", token));
+
+			std::size_t index = 0;
+			for (char c : token)
+			{
+				if (c < '0' || c > '9') throw std::runtime_error(std::format("\"{}\" is not a valid array index", token));
+
+				index = index * 10 + (c - '0');
+
+				//checked as it grows so long tokens cannot wrap around into range
+				if (index > size) throw std::runtime_error(std::format("Array index {} is out of range", token));
+			}
+
+			if (index > size || (index == size && !allowEnd)) throw std::runtime_error(std::format("Array index {} is out of range", token));
+
+			return index;
+		}
+
+		JsonValue* resolve(JsonValue& document, const Pointer& path, std::size_t count)
+		{
+			JsonValue* node = &document;
+
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (node->isDictionary())
+				{
+					if (!node->contains(path[i])) return nullptr;
+
+					node = &(*node)[path[i]];
+				}
+				else if (node->isArray())
+				{
+					//patching into a packed array needs nodes for its elements
+					node->unpack();
+					node = &(*node)[parseIndex(path[i], node->size(), false)];
+				}
+				else
+				{
+					return nullptr;
+				}
+			}
+
+			return node;
+		}
+
+		JsonValue& resolveExisting(JsonValue& document, const Pointer& path)
+		{
+			JsonValue* node = resolve(document, path, path.size());
+			if (!node) throw std::runtime_error("Json pointer does not reference an existing value");
+
+			return *node;
+		}
+
+		JsonValue& resolveParent(JsonValue& document, const Pointer& path)
+		{
+			JsonValue* parent = resolve(document, path, path.size() - 1);
+			if (!parent || !(parent->isDictionary() || parent->isArray())) throw std::runtime_error("Json pointer parent is not a dictionary or array");
+
+			parent->unpack();
+
+			return *parent;
+		}
+
+		//rewrites an appending "-" in path to the index actually used, returns true if an existing value was moved into replaced
+		bool addAt(JsonValue& document, Pointer& path, JsonValue&& value, JsonValue& replaced)
+		{
+			if (path.empty())
+			{
+				replaced = std::move(document);
+				document = std::move(value);
+
+				return true;
+			}
+
+			JsonValue& parent = resolveParent(document, path);
+
+			if (parent.isDictionary())
+			{
+				bool existed = parent.contains(path.back());
+				JsonValue& slot = parent[path.back()];
+
+				if (existed) replaced = std::move(slot);
+
+				slot = std::move(value);
+
+				return existed;
+			}
+
+			std::size_t index = parseIndex(path.back(), parent.size(), true);
+			parent.insert(index, std::move(value));
+
+			path.back() = std::to_string(index);
+
+			return false;
+		}
+
+		JsonValue removeAt(JsonValue& document, const Pointer& path)
+		{
+			if (path.empty()) throw std::runtime_error("Unable to remove the root of a document");
+
+			JsonValue& parent = resolveParent(document, path);
+			JsonValue res;
+
+			if (parent.isDictionary())
+			{
+				if (!parent.contains(path.back())) throw std::runtime_error(std::format("Key \"{}\" does not exist", path.back()));
+
+				res = std::move(parent[path.back()]);
+				parent.remove(path.back());
+			}
+			else
+			{
+				std::size_t index = parseIndex(path.back(), parent.size(), false);
+
+				res = std::move(parent[index]);
+				parent.remove(index);
+			}
+
+			return res;
+		}
+
+		void rollback(JsonValue& document, std::vector<UndoEntry>& undo)
+		{
+			JsonValue discarded;
+
+			for (auto it = undo.rbegin(); it != undo.rend(); it++)
+			{
+				switch (it->kind)
+				{
+				case UndoEntry::Kind::Added:
+					removeAt(document, it->path);
+					break;
+
+				case UndoEntry::Kind::Removed:
+					addAt(document, it->path, std::move(it->value), discarded);
+					break;
+
+				case UndoEntry::Kind::Replaced:
+					if (it->path.empty())
+						document = std::move(it->value);
+					else
+						resolveExisting(document, it->path) = std::move(it->value);
+					break;
+
+				case UndoEntry::Kind::Moved:
+				{
+					JsonValue moved = it->replaced ? std::move(resolveExisting(document, it->path)) : removeAt(document, it->path);
+
+					if (it->replaced)
+					{
+						if (it->path.empty())
+							document = std::move(it->value);
+						else
+							resolveExisting(document, it->path) = std::move(it->value);
+					}
+
+					addAt(document, it->from, std::move(moved), discarded);
+					break;
+				}
+				}
+			}
+		}
+
+		std::string getMember(const JsonValue& operation, const std::string& key, std::size_t index)
+		{
+			if (!operation.contains(key) || !operation[key].isString())
+				throw std::runtime_error(std::format("Patch operation {} is missing \"{}\"", index, key));
+
+			return operation[key].as<std::string>();
+		}
+
+		void add(JsonValue& document, Pointer path, JsonValue&& value, std::vector<UndoEntry>& undo)
+		{
+			JsonValue replaced;
+
+			if (addAt(document, path, std::move(value), replaced))
+				undo.push_back({ UndoEntry::Kind::Replaced, std::move(path), std::move(replaced) });
+			else
+				undo.push_back({ UndoEntry::Kind::Added, std::move(path) });
+		}
+
+		//movableOperation aliases operation when the caller handed the patch over, values are then moved out of it
+		void applyOperation(JsonValue& document, const JsonValue& operation, JsonValue* movableOperation, std::size_t index, std::vector<UndoEntry>& undo)
+		{
+			if (!operation.isDictionary()) throw std::runtime_error(std::format("Patch operation {} is not a dictionary", index));
+
+			std::string op = getMember(operation, "op", index);
+			Pointer path = parsePointer(getMember(operation, "path", index));
+
+			auto takeValue = [&]() -> JsonValue
+			{
+				if (!operation.contains("value")) throw std::runtime_error(std::format("Patch operation {} is missing \"value\"", index));
+
+				if (movableOperation) return std::move((*movableOperation)["value"]);
+
+				return operation["value"];
+			};
+
+			if (op == "add")
+			{
+				add(document, std::move(path), takeValue(), undo);
+			}
+			else if (op == "remove")
+			{
+				JsonValue removed = removeAt(document, path);
+
+				undo.push_back({ UndoEntry::Kind::Removed, std::move(path), std::move(removed) });
+			}
+			else if (op == "replace")
+			{
+				JsonValue& slot = resolveExisting(document, path);
+				JsonValue value = takeValue();
+
+				undo.push_back({ UndoEntry::Kind::Replaced, std::move(path), std::move(slot) });
+
+				slot = std::move(value);
+			}
+			else if (op == "move")
+			{
+				Pointer from = parsePointer(getMember(operation, "from", index));
+
+				//from has to exist even when the move would change nothing
+				resolveExisting(document, from);
+				if (from == path) return;
+
+				if (from.size() < path.size() && std::equal(from.begin(), from.end(), path.begin()))
+					throw std::runtime_error(std::format("Patch operation {} moves a value into itself", index));
+
+				JsonValue moved = removeAt(document, from);
+				JsonValue replaced;
+				bool didReplace;
+
+				try
+				{
+					didReplace = addAt(document, path, std::move(moved), replaced);
+				}
+				catch (...)
+				{
+					addAt(document, from, std::move(moved), replaced);
+
+					throw;
+				}
+
+				UndoEntry entry = { UndoEntry::Kind::Moved, std::move(path), std::move(replaced), std::move(from), didReplace };
+				undo.push_back(std::move(entry));
+			}
+			else if (op == "copy")
+			{
+				Pointer from = parsePointer(getMember(operation, "from", index));
+
+				add(document, std::move(path), JsonValue(resolveExisting(document, from)), undo);
+			}
+			else if (op == "test")
+			{
+				JsonValue* node = resolve(document, path, path.size());
+
+				if (!node || !operation.contains("value") || *node != operation["value"]) throw std::runtime_error(std::format("Patch operation {} failed its test", index));
+			}
+			else
+			{
+				throw std::runtime_error(std::format("Patch operation {} has an unknown op \"{}\"", index, op));
+			}
+		}
+
+		void applyPatch(JsonValue& document, const JsonValue& patch, JsonValue* movablePatch)
+		{
+			if (!patch.isArray()) throw std::runtime_error("Json patch must be an array of operations");
+
+			std::vector<UndoEntry> undo;
+
+			try
+			{
+				for (std::size_t i = 0; i < patch.size(); i++)
+				{
+					applyOperation(document, patch[i], movablePatch ? &(*movablePatch)[i] : nullptr, i, undo);
+				}
+			}
+			catch (...)
+			{
+				rollback(document, undo);
+
+				throw;
+			}
+		}
+
+		void pushOperation(JsonValue& patch, const char* op, const std::string& path, const JsonValue* value)
+		{
+			JsonValue operation;
+			operation["op"] = op;
+			operation["path"] = path;
+
+			if (value) operation["value"] = *value;
+
+			patch.push_back(std::move(operation));
+		}
+	}
+
+	void JsonPatch::apply(JsonValue& document, const JsonValue& patch)
+	{
+		applyPatch(document, patch, nullptr);
+	}
+
+	void JsonPatch::apply(JsonValue& document, JsonValue&& patch)
+	{
+		applyPatch(document, patch, &patch);
+	}
+
+	void JsonPatch::applyMerge(JsonValue& document, const JsonValue& patch)
+	{
+		if (patch.type != JsonValue::Type::Dictionary)
+		{
+			document = patch;
+			return;
+		}
+
+		if (document.type != JsonValue::Type::Dictionary)
+		{
+			document.setType(JsonValue::Type::Null);
+			document.setType(JsonValue::Type::Dictionary);
+		}
+
+		document.invalidateHash();
+
+		for (auto& [k, v] : patch.m)
+		{
+			if (v.type == JsonValue::Type::Null)
+				document.m.erase(k);
+			else
+				applyMerge(document.m[k], v);
+		}
+	}
+
+	JsonValue JsonPatch::diff(const JsonValue& from, const JsonValue& to)
+	{
+		JsonValue patch;
+		patch.setType(JsonValue::Type::Array);
+
+		std::string path;
+		diffValues(from, to, path, patch);
+
+		return patch;
+	}
+
+	//arrays are diffed by trimming the common prefix and suffix, then pairing up what is left
+	void JsonPatch::diffValues(const JsonValue& from, const JsonValue& to, std::string& path, JsonValue& patch)
+	{
+		if (from.type != to.type || (from.type != JsonValue::Type::Dictionary && from.type != JsonValue::Type::Array))
+		{
+			if (from != to) pushOperation(patch, "replace", path, &to);
+
+			return;
+		}
+
+		std::size_t pathSize = path.size();
+
+		if (from.type == JsonValue::Type::Dictionary)
+		{
+			for (auto& [k, v] : from.m)
+			{
+				appendPointerToken(path, k);
+
+				auto it = to.m.find(k);
+				if (it == to.m.end())
+					pushOperation(patch, "remove", path, nullptr);
+				else
+					diffValues(v, it->second, path, patch);
+
+				path.resize(pathSize);
+			}
+
+			for (auto& [k, v] : to.m)
+			{
+				if (from.m.contains(k)) continue;
+
+				appendPointerToken(path, k);
+				pushOperation(patch, "add", path, &v);
+				path.resize(pathSize);
+			}
+
+			return;
+		}
+
+		//packed arrays are expanded into locals here rather than building the nodes they would keep
+		std::pmr::vector<JsonValue> fromUnpacked, toUnpacked;
+
+		if (from.packed) fromUnpacked.assign(from.p.values.begin(), from.p.values.end());
+		if (to.packed) toUnpacked.assign(to.p.values.begin(), to.p.values.end());
+
+		const std::pmr::vector<JsonValue>& fromElements = from.packed ? fromUnpacked : from.v;
+		const std::pmr::vector<JsonValue>& toElements = to.packed ? toUnpacked : to.v;
+
+		std::size_t fromEnd = fromElements.size();
+		std::size_t toEnd = toElements.size();
+		std::size_t start = 0;
+
+		while (start < fromEnd && start < toEnd && fromElements[start] == toElements[start]) start++;
+		while (fromEnd > start && toEnd > start && fromElements[fromEnd - 1] == toElements[toEnd - 1])
+		{
+			fromEnd--;
+			toEnd--;
+		}
+
+		std::size_t paired = std::min(fromEnd - start, toEnd - start);
+
+		for (std::size_t i = start; i < start + paired; i++)
+		{
+			appendPointerToken(path, std::to_string(i));
+			diffValues(fromElements[i], toElements[i], path, patch);
+			path.resize(pathSize);
+		}
+
+		//removing at the same index repeatedly shifts the rest of the array down
+		appendPointerToken(path, std::to_string(start + paired));
+
+		for (std::size_t i = start + paired; i < fromEnd; i++)
+			pushOperation(patch, "remove", path, nullptr);
+
+		path.resize(pathSize);
+
+		for (std::size_t i = start + paired; i < toEnd; i++)
+		{
+			appendPointerToken(path, std::to_string(i));
+			pushOperation(patch, "add", path, &toElements[i]);
+			path.resize(pathSize);
+		}
+	}
+}
\ No newline at end of file
@@ -1,101 +1,103 @@
 #include "JsonValue.h"
 
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <string_view>
+
+#include "StringUtils.h"
+
+inline std::uint64_t mixHash(std::uint64_t h)
+{
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ull;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebull;
+	h ^= h >> 31;
+
+	return h;
+}
+
+inline std::uint64_t numberHash(double n)
+{
+	//-0 and 0 compare equal
+	return mixHash(std::bit_cast<std::uint64_t>(n == 0 ? 0.0 : n) + (std::uint64_t)Jsonify::JsonValue::Type::Number);
+}
+
 namespace Jsonify
 {
 	JsonValue::JsonValue()
-		: type(Type::Null), b(0)
+		: type(Type::Null), hashCache(0), b(0)
 	{
 	}
 
 	JsonValue::JsonValue(double n)
-		: type(Type::Number), n(n)
+		: type(Type::Number), hashCache(0), n(n)
 	{
 	}
 
 	JsonValue::JsonValue(int n)
-		: type(Type::Number), n(n)
+		: type(Type::Number), hashCache(0), n(n)
 	{
 	}
 
 	JsonValue::JsonValue(float n)
-		: type(Type::Number), n(n)
+		: type(Type::Number), hashCache(0), n(n)
 	{
 	}
 
 	JsonValue::JsonValue(bool b)
-		: type(Type::Boolean), b(b)
+		: type(Type::Boolean), hashCache(0), b(b)
 	{
 	}
 
 	JsonValue::JsonValue(std::string s)
-		: type(Type::String), s(s)
+		: type(Type::String), hashCache(0), s(s, allocator)
 	{
 	}
 
 	JsonValue::JsonValue(const char* s)
-		: type(Type::String), s(s)
+		: type(Type::String), hashCache(0), s(s, allocator)
 	{
 	}
 
 	JsonValue::JsonValue(Null)
-		: type(Type::Null), b(0)
+		: type(Type::Null), hashCache(0), b(0)
 	{
 	}
 
-	JsonValue::JsonValue(const JsonValue& other)
-		: type(other.type), b(0)
+	JsonValue::JsonValue(std::allocator_arg_t, const allocator_type& allocator)
+		: type(Type::Null), hashCache(0), allocator(allocator), b(0)
 	{
-		switch (type)
-		{
-		case Type::String:
-			new (&s) std::string(other.s);
-			break;
-
-		case Type::Dictionary:
-			new (&m) std::unordered_map(other.m);
-			break;
+	}
 
-		case Type::Array:
-			new (&v) std::vector(other.v);
-			break;
+	JsonValue::JsonValue(std::allocator_arg_t, const allocator_type& allocator, const JsonValue& other)
+		: type(Type::Null), hashCache(0), allocator(allocator), b(0)
+	{
+		*this = other;
+	}
 
-		case Type::Number:
-			n = other.n;
-			break;
+	JsonValue::JsonValue(std::allocator_arg_t, const allocator_type& allocator, JsonValue&& other)
+		: type(Type::Null), hashCache(0), allocator(allocator), b(0)
+	{
+		*this = std::move(other);
+	}
 
-		case Type::Boolean:
-			b = other.b;
-			break;
-		}
+	JsonValue::JsonValue(const JsonValue& other)
+		: JsonValue(std::allocator_arg, allocator_type(), other)
+	{
 	}
 
 	JsonValue::JsonValue(JsonValue&& other) noexcept
-		: type(Type::Null), b(0)
+		: JsonValue(std::allocator_arg, other.allocator, std::move(other))
 	{
-		setType(other.type);
-
-		switch (type)
-		{
-		case Type::String:
-			s = std::move(other.s);
-			break;
-
-		case Type::Dictionary:
-			m = std::move(other.m);
-			break;
-
-		case Type::Array:
-			v = std::move(other.v);
-			break;
-
-		case Type::Number:
-			n = other.n;
-			break;
+	}
 
-		case Type::Boolean:
-			b = other.b;
-			break;
-		}
+	JsonValue::allocator_type JsonValue::get_allocator() const
+	{
+		return allocator;
 	}
 
 	bool JsonValue::isString() const
@@ -133,9 +135,55 @@ namespace Jsonify
 		return type == Type::Boolean ? b : type != Type::Null;
 	}
 
+	bool JsonValue::isPacked() const
+	{
+		return type == Type::Array && packed;
+	}
+
+	bool JsonValue::isRawNumber() const
+	{
+		return type == Type::Number && rawNumber;
+	}
+
+	std::string_view JsonValue::getRawNumber() const
+	{
+		if (type != Type::Number || !rawNumber) throw std::runtime_error("Type is not a raw number");
+
+		return s;
+	}
+
+	bool JsonValue::pack()
+	{
+		if (type != Type::Array) return false;
+		if (packed) return true;
+
+		std::pmr::vector<double> values(allocator);
+		values.reserve(v.size());
+
+		for (const JsonValue& val : v)
+		{
+			if (val.type != Type::Number) return false;
+
+			values.push_back(val.number());
+		}
+
+		setPacked();
+		p.values = std::move(values);
+
+		return true;
+	}
+
 	JsonValue& JsonValue::operator=(JsonValue&& other) noexcept
 	{
-		setType(other.type);
+		if (this == &other) return *this;
+		if (type != other.type || packed != other.packed || rawNumber != other.rawNumber) setType(Type::Null);
+
+		if (other.packed)
+			setPacked();
+		else if (other.rawNumber)
+			setRawNumber({});
+		else
+			setType(other.type);
 
 		switch (type)
 		{
@@ -148,11 +196,17 @@ namespace Jsonify
 			break;
 
 		case Type::Array:
-			v = std::move(other.v);
+			if (packed)
+				p.values = std::move(other.p.values);
+			else
+				v = std::move(other.v);
 			break;
 
 		case Type::Number:
-			n = other.n;
+			if (rawNumber)
+				s = std::move(other.s);
+			else
+				n = other.n;
 			break;
 
 		case Type::Boolean:
@@ -160,12 +214,23 @@ namespace Jsonify
 			break;
 		}
 
+		//the children moved along with their storage, references handed out for them still reach them
+		if (other.exposed) exposed = true;
+
 		return *this;
 	}
 	
 	JsonValue& JsonValue::operator=(const JsonValue& other)
 	{
-		setType(other.type);
+		if (this == &other) return *this;
+		if (type != other.type || packed != other.packed || rawNumber != other.rawNumber) setType(Type::Null);
+
+		if (other.packed)
+			setPacked();
+		else if (other.rawNumber)
+			setRawNumber({});
+		else
+			setType(other.type);
 
 		switch (type)
 		{
@@ -178,11 +243,17 @@ namespace Jsonify
 			break;
 
 		case Type::Array:
-			v = other.v;
+			if (packed)
+				p.values = other.p.values;
+			else
+				v = other.v;
 			break;
 
 		case Type::Number:
-			n = other.n;
+			if (rawNumber)
+				s = other.s;
+			else
+				n = other.n;
 			break;
 
 		case Type::Boolean:
@@ -195,14 +266,23 @@ namespace Jsonify
 
 	bool JsonValue::operator==(const JsonValue& other) const
 	{
+		if (this == &other) return true;
 		if (type != other.type) return false;
 
+		//a cached hash is always current, so two that differ settle it without walking the children
+		std::uint64_t hash = hashCache.load(std::memory_order_relaxed);
+		std::uint64_t otherHash = other.hashCache.load(std::memory_order_relaxed);
+
+		if (hash != 0 && otherHash != 0 && hash != otherHash) return false;
+
 		switch (type)
 		{
 		case Type::String:
 			return s == other.s;
 
 		case Type::Number:
+			if (rawNumber || other.rawNumber) return number() == other.number();
+
 			return n == other.n;
 
 		case Type::Boolean:
@@ -212,6 +292,22 @@ namespace Jsonify
 			return m == other.m;
 
 		case Type::Array:
+			if (packed && other.packed) return p.values == other.p.values;
+
+			if (packed || other.packed)
+			{
+				//compared against the doubles, building nodes for the packed side would allocate
+				const std::pmr::vector<double>& values = packed ? p.values : other.p.values;
+				const std::pmr::vector<JsonValue>& nodes = packed ? other.v : v;
+
+				if (values.size() != nodes.size()) return false;
+
+				for (std::size_t i = 0; i < values.size(); i++)
+					if (nodes[i].type != Type::Number || nodes[i].number() != values[i]) return false;
+
+				return true;
+			}
+
 			return v == other.v;
 
 		case Type::Null:
@@ -227,33 +323,97 @@ namespace Jsonify
 		return !(*this == other);
 	}
 
+	std::uint64_t JsonValue::hash() const
+	{
+		switch (type)
+		{
+		case Type::String:
+			return mixHash(std::hash<std::string_view>()(s) + (std::uint64_t)Type::String);
+
+		case Type::Number:
+			return numberHash(number());
+
+		case Type::Boolean:
+			return mixHash((b ? 2 : 1) + ((std::uint64_t)Type::Boolean << 8));
+
+		case Type::Null:
+			return mixHash((std::uint64_t)Type::Null << 8);
+		}
+
+		std::uint64_t res = hashCache.load(std::memory_order_relaxed);
+		if (res != 0) return res;
+
+		if (type == Type::Array)
+		{
+			res = (std::uint64_t)Type::Array;
+
+			if (packed)
+			{
+				for (double val : p.values)
+					res = mixHash(res + numberHash(val));
+			}
+			else
+			{
+				for (const JsonValue& val : v)
+					res = mixHash(res + val.hash());
+			}
+		}
+		else
+		{
+			//entries are combined with a sum so the map's iteration order does not matter
+			std::uint64_t sum = 0;
+
+			for (const auto& [k, val] : m)
+				sum += mixHash(std::hash<std::string_view>()(k) ^ std::rotl(val.hash(), 1));
+
+			res = mixHash(sum + (std::uint64_t)Type::Dictionary);
+		}
+
+		if (res == 0) res = 1;
+
+		//a child handed out by reference can change without this node knowing
+		if (!exposed) hashCache.store(res, std::memory_order_relaxed);
+
+		return res;
+	}
+
 	JsonValue& JsonValue::getOrDefault(const std::string& key, const JsonValue& defaultValue)
 	{
-		setType(Type::Dictionary);
+		JsonValue& value = (*this)[key];
 
-		if (!m.contains(key) || m[key].isNull())
-			m[key] = defaultValue;
+		if (value.isNull())
+			value = defaultValue;
 
-		return m[key];
+		return value;
 	}
 
 	JsonValue& JsonValue::operator[](const std::string& key)
 	{
 		setType(Type::Dictionary);
+		exposed = true;
 
-		return m[key];
+		auto it = m.find(key);
+		if (it == m.end()) it = m.try_emplace(std::pmr::string(key, allocator)).first;
+
+		return it->second;
 	}
 
 	const JsonValue& JsonValue::operator[](const std::string& key) const
 	{
 		if (type != Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
 
-		return m.at(key);
+		auto it = m.find(key);
+		if (it == m.end()) throw std::out_of_range("Key not found");
+
+		return it->second;
 	}
 
 	void JsonValue::remove(const std::string& key)
 	{
-		m.erase(key);
+		invalidateHash();
+
+		auto it = m.find(key);
+		if (it != m.end()) m.erase(it);
 	}
 
 	bool JsonValue::contains(const std::string& key) const
@@ -263,9 +423,41 @@ namespace Jsonify
 		return m.find(key) != m.end();
 	}
 
+	JsonValue& JsonValue::operator[](const Key& key)
+	{
+		setType(Type::Dictionary);
+		exposed = true;
+
+		auto it = m.find(key);
+		if (it == m.end()) it = m.try_emplace(std::pmr::string(key.name, allocator)).first;
+
+		return it->second;
+	}
+
+	const JsonValue& JsonValue::operator[](const Key& key) const
+	{
+		if (type != Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+
+		auto it = m.find(key);
+		if (it == m.end()) throw std::out_of_range("Key not found");
+
+		return it->second;
+	}
+
+	bool JsonValue::contains(const Key& key) const
+	{
+		if (type != Type::Dictionary) throw std::runtime_error("Type is not a dictionary");
+
+		return m.find(key) != m.end();
+	}
+
 	JsonValue& JsonValue::operator[](std::size_t index)
 	{
 		setType(Type::Array);
+
+		if (packed) throw std::runtime_error("Array is packed, use get or asSpan or unpack it first");
+
+		exposed = true;
 		
 		return v[index];
 	}
@@ -273,6 +465,7 @@ namespace Jsonify
 	const JsonValue& JsonValue::operator[](std::size_t index) const
 	{
 		if (type != Type::Array) throw std::runtime_error("Type is not an array");
+		if (packed) throw std::runtime_error("Array is packed, use get or asSpan or unpack it first");
 
 		return v[index];
 	}
@@ -281,6 +474,14 @@ namespace Jsonify
 	{
 		setType(Type::Array);
 
+		if (packed && val.type == Type::Number)
+		{
+			p.values.push_back(val.number());
+
+			return;
+		}
+
+		unpack();
 		v.push_back(val);
 	}
 
@@ -288,19 +489,54 @@ namespace Jsonify
 	{
 		setType(Type::Array);
 
-		v.push_back(val);
+		if (packed && val.type == Type::Number)
+		{
+			p.values.push_back(val.number());
+
+			return;
+		}
+
+		unpack();
+		v.push_back(std::move(val));
+	}
+
+	void JsonValue::insert(std::size_t index, JsonValue&& val)
+	{
+		setType(Type::Array);
+		unpack();
+
+		if (index > v.size()) throw std::runtime_error("Array index out of range");
+
+		v.insert(v.begin() + index, std::move(val));
+	}
+
+	void JsonValue::remove(std::size_t index)
+	{
+		invalidateHash();
+
+		if (type != Type::Array) throw std::runtime_error("Type is not an array");
+
+		unpack();
+
+		if (index >= v.size()) throw std::runtime_error("Array index out of range");
+
+		v.erase(v.begin() + index);
 	}
 
 	void JsonValue::reserve(std::size_t amount)
 	{
 		setType(Type::Array);
 
-		v.reserve(amount);
+		if (packed)
+			p.values.reserve(amount);
+		else
+			v.reserve(amount);
 	}
 
 	void JsonValue::resize(std::size_t to)
 	{
 		setType(Type::Array);
+		unpack();
 
 		v.resize(to);
 	}
@@ -309,7 +545,7 @@ namespace Jsonify
 	{
 		if (type == Type::Array)
 		{
-			return v.size();
+			return packed ? p.values.size() : v.size();
 		}
 		else if (type == Type::Dictionary)
 		{
@@ -335,12 +571,34 @@ namespace Jsonify
 
 	JsonValue::Iterator JsonValue::begin()
 	{
+		invalidateHash();
+
 		if (type != Type::Dictionary) throw std::runtime_error("Only dictionaries are iterable");
+
+		exposed = true;
 		
 		return m.begin();
 	}
 
 	JsonValue::Iterator JsonValue::end()
+	{
+		invalidateHash();
+
+		if (type != Type::Dictionary) throw std::runtime_error("Only dictionaries are iterable");
+
+		exposed = true;
+
+		return m.end();
+	}
+
+	JsonValue::ConstIterator JsonValue::begin() const
+	{
+		if (type != Type::Dictionary) throw std::runtime_error("Only dictionaries are iterable");
+
+		return m.begin();
+	}
+
+	JsonValue::ConstIterator JsonValue::end() const
 	{
 		if (type != Type::Dictionary) throw std::runtime_error("Only dictionaries are iterable");
 
@@ -354,6 +612,8 @@ namespace Jsonify
 
 	void JsonValue::setType(Type type)
 	{
+		invalidateHash();
+
 		if (this->type == type) return;
 		if (type != Type::Null &&
 			this->type != Type::Null &&
@@ -362,17 +622,29 @@ namespace Jsonify
 		switch (this->type)
 		{
 		case Type::Array:
-			v.~vector();
+			if (packed)
+				p.~PackedArray();
+			else
+				v.~vector();
+
+			packed = false;
+			exposed = false;
 			break;
 
 		case Type::Dictionary:
 			m.~unordered_map();
+			exposed = false;
 			break;
 
 		case Type::String:
 			s.~basic_string();
 			break;
 
+		case Type::Number:
+			if (rawNumber) s.~basic_string();
+
+			rawNumber = false;
+			break;
 		}
 
 		this->type = type;
@@ -380,15 +652,15 @@ namespace Jsonify
 		switch (this->type)
 		{
 		case Type::Array:
-			new (&v) std::vector<JsonValue>;
+			new (&v) std::pmr::vector<JsonValue>(allocator);
 			break;
 
 		case Type::Dictionary:
-			new (&m) std::unordered_map<std::string, JsonValue>;
+			new (&m) Map(allocator);
 			break;
 
 		case Type::String:
-			new (&s) std::string;
+			new (&s) std::pmr::string(allocator);
 			break;
 
 		case Type::Boolean:
@@ -405,4 +677,84 @@ namespace Jsonify
 	{
 		return type;
 	}
+
+	void JsonValue::invalidateHash()
+	{
+		hashCache.store(0, std::memory_order_relaxed);
+	}
+
+	void JsonValue::setPacked()
+	{
+		invalidateHash();
+
+		if (type == Type::Array && packed) return;
+
+		setType(Type::Null);
+
+		type = Type::Array;
+		packed = true;
+		new (&p) PackedArray(allocator);
+	}
+
+	void JsonValue::unpack()
+	{
+		if (!packed) return;
+
+		std::pmr::vector<JsonValue> nodes(p.values.begin(), p.values.end(), allocator);
+
+		p.~PackedArray();
+		new (&v) std::pmr::vector<JsonValue>(std::move(nodes));
+		packed = false;
+	}
+
+	void JsonValue::setRawNumber(std::string_view text)
+	{
+		if (type != Type::Number || !rawNumber)
+		{
+			setType(Type::Null);
+
+			type = Type::Number;
+			rawNumber = true;
+			new (&s) std::pmr::string(allocator);
+		}
+
+		invalidateHash();
+		s.assign(text);
+	}
+
+	double JsonValue::number() const
+	{
+		if (!rawNumber) return n;
+
+		return numberFromLiteral(s);
+	}
+
+	template<typename T>
+	T JsonValue::integer() const
+	{
+		if (rawNumber)
+		{
+			T res;
+			auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), res);
+
+			//written with a fraction or an exponent, or out of range
+			if (ec == std::errc() && end == s.data() + s.size()) return res;
+		}
+
+		double num = number();
+		double limit = std::ldexp(1.0, std::numeric_limits<T>::digits);
+
+		if (num != std::trunc(num) || num < (double)std::numeric_limits<T>::min() || num >= limit)
+			throw std::runtime_error(std::format("Number {} is not a representable integer", num));
+
+		return (T)num;
+	}
+
+	template std::int64_t JsonValue::integer<std::int64_t>() const;
+	template std::uint64_t JsonValue::integer<std::uint64_t>() const;
+
+	JsonValue::PackedArray::PackedArray(const allocator_type& allocator)
+		: values(allocator)
+	{
+	}
 }
\ No newline at end of file
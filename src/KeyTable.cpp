@@ -0,0 +1,40 @@
+#include "KeyTable.h"
+
+#include <mutex>
+
+namespace Jsonify
+{
+	JsonValue::Key KeyTable::intern(std::string_view name)
+	{
+		JsonValue::Key key(name);
+
+		{
+			std::shared_lock lock(mutex);
+
+			auto it = keys.find(key);
+
+			if (it != keys.end())
+			{
+				key.name = *it;
+				return key;
+			}
+		}
+
+		std::unique_lock lock(mutex);
+
+		//another thread may have added it between the two locks
+		auto it = keys.find(key);
+		if (it == keys.end()) it = keys.emplace(name).first;
+
+		key.name = *it;
+
+		return key;
+	}
+
+	std::size_t KeyTable::size() const
+	{
+		std::shared_lock lock(mutex);
+
+		return keys.size();
+	}
+}
\ No newline at end of file
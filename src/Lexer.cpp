@@ -2,10 +2,7 @@
 
 #include <cctype>
 
-inline bool isNewline(char c)
-{
-	return c == '\n';
-}
+#include "StringUtils.h"
 
 inline bool isEscape(char c)
 {
@@ -19,34 +16,45 @@ inline bool isEscape(char c)
 
 namespace Jsonify
 {
-	Lexer::Lexer(const std::string& source)
-		: lineNumber(1), pointer(0), source(source)
+	Lexer::Lexer(std::string_view source)
+		: current({ Token::Type::Eof, { 0, 0 }, std::string_view() }), source(source), pointer(0)
+	{
+	}
+
+	void Lexer::reset(std::string_view source)
 	{
+		this->source = source;
+		pointer = 0;
+		current = { Token::Type::Eof, { 0, 0 }, std::string_view() };
 	}
 
 	const Token& Lexer::nextToken()
 	{
-		if (tokens.size() > 0)
-			tokens.pop_front();
+		current = parseToken();
 
-		if (tokens.size() == 0)
-			tokens.push_back(parseToken());
+		return current;
+	}
+
+	const Token& Lexer::seek(std::size_t offset)
+	{
+		pointer = offset;
 
-		return tokens.front();
+		return nextToken();
 	}
 
-	const Token& Lexer::peekToken(int amount)
+	Token Lexer::peekToken(int amount)
 	{
-		if (tokens.size() >= amount + 1)
-			return tokens[amount];
+		std::size_t saved = pointer;
 
-		std::size_t am = amount - tokens.size() + 1;
-		for (std::size_t i = 0; i < am; i++)
+		Token tok = current;
+		for (int i = 0; i < amount; i++)
 		{
-			tokens.push_back(parseToken());
+			tok = parseToken();
 		}
 
-		return tokens[amount];
+		pointer = saved;
+
+		return tok;
 	}
 
 	bool Lexer::isEnd() const
@@ -56,17 +64,22 @@ namespace Jsonify
 
 	const Token& Lexer::readToken() const
 	{
-		return tokens.front();
+		return current;
 	}
 
-	const Token Lexer::parseToken()
+	Token Lexer::parseToken()
 	{
+		while (readChar() == ' ' || isEscape(readChar()))
+		{
+			consume();
+		}
+
 		if (!readChar())
-			return { Token::Type::Eof, { pointer, pointer, lineNumber }, std::string_view() };
+			return { Token::Type::Eof, { pointer, pointer }, std::string_view() };
 
 		if (readChar() == ',' || readChar() == ':' || readChar() == '{' || readChar() == '}' || readChar() == '[' || readChar() == ']')
 		{
-			Token tok = { Token::Type::Char, { pointer, pointer, lineNumber }, std::string_view(source.data() + pointer, 1) };
+			Token tok = { Token::Type::Char, { pointer, pointer }, std::string_view(source.data() + pointer, 1) };
 
 			consume();
 
@@ -78,17 +91,13 @@ namespace Jsonify
 			consume();
 
 			std::size_t strStart = pointer;
+			std::size_t strEnd = findStringEnd(source, strStart);
 
-			while (readChar() && readChar() != '"' && !isNewline(readChar()))
+			if (strEnd != std::string_view::npos)
 			{
-				consume();
-			}
-
-			std::string_view string = std::string_view(source.data() + strStart, pointer - strStart);
+				pointer = strEnd;
 
-			if (readChar() == '"')
-			{
-				Token tok = { Token::Type::String, { strStart, pointer - 1, lineNumber }, string };
+				Token tok = { Token::Type::String, { strStart, pointer - 1 }, std::string_view(source.data() + strStart, pointer - strStart) };
 
 				consume();
 
@@ -96,7 +105,13 @@ namespace Jsonify
 			}
 			else
 			{
-				return { Token::Type::BrokenString, { strStart, pointer - 1, lineNumber }, string };
+				//a broken string runs up to the offending control character or the end of the source
+				while (readChar() && (unsigned char)readChar() >= 0x20)
+				{
+					consume();
+				}
+
+				return { Token::Type::BrokenString, { strStart, pointer - 1 }, std::string_view(source.data() + strStart, pointer - strStart) };
 			}
 		}
 
@@ -115,15 +130,15 @@ namespace Jsonify
 
 			if (identifer.compare("null") == 0)
 			{
-				tok = { Token::Type::Null, { identStart, pointer - 1, lineNumber }, identifer };
+				tok = { Token::Type::Null, { identStart, pointer - 1 }, identifer };
 			}
 			else if (identifer.compare("true") == 0 || identifer.compare("false") == 0)
 			{
-				tok = { Token::Type::Boolean, { identStart, pointer - 1, lineNumber }, identifer };
+				tok = { Token::Type::Boolean, { identStart, pointer - 1 }, identifer };
 			}
 			else
 			{
-				tok = { Token::Type::Unknown, { identStart, pointer - 1, lineNumber }, identifer };
+				tok = { Token::Type::Unknown, { identStart, pointer - 1 }, identifer };
 			}
 
 			return tok;
@@ -135,37 +150,17 @@ namespace Jsonify
 
 			consume();
 
-			while (isdigit(readChar()) || readChar() == 'e' || readChar() == '-' || readChar() == '+' || readChar() == '.')
+			while (isdigit(readChar()) || readChar() == 'e' || readChar() == 'E' || readChar() == '-' || readChar() == '+' || readChar() == '.')
 			{
 				consume();
 			}
 
 			std::string_view number = std::string_view(source.data() + numberStart, pointer - numberStart);
 
-			return { Token::Type::Number, { numberStart, pointer - 1, lineNumber }, number };
+			return { Token::Type::Number, { numberStart, pointer - 1 }, number };
 		}
 
-		if (readChar() == ' ')
-		{
-			while (readChar() == ' ')
-			{
-				consume();
-			}
-
-			return parseToken();
-		};
-
-		if (isEscape(readChar()))
-		{
-			while (isEscape(readChar()))
-			{
-				consume();
-			}
-
-			return parseToken();
-		}
-
-		Token tok = { Token::Type::Unknown, { pointer, pointer, lineNumber }, std::string_view(source.data() + pointer, 1) };
+		Token tok = { Token::Type::Unknown, { pointer, pointer }, std::string_view(source.data() + pointer, 1) };
 		consume();
 
 		return tok;
@@ -174,20 +169,14 @@ namespace Jsonify
 
 	char Lexer::consume()
 	{
-		char c = source[pointer];
-
-		if (c == '\n')
-		{
-			lineNumber++;
-		}
-
-		pointer++;
-
-		return c;
+		return source[pointer++];
 	}
 
 	char Lexer::readChar() const
 	{
+		if (pointer >= source.size())
+			return '\0';
+
 		return source[pointer];
 	}
 
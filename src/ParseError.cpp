@@ -0,0 +1,82 @@
+#include "ParseError.h"
+
+#include <format>
+
+#include "Lexer.h"
+#include "StringUtils.h"
+
+namespace Jsonify
+{
+	bool ParseError::fail(Kind kind, const Token& tok)
+	{
+		this->kind = kind;
+		offset = tok.location.start;
+
+		return false;
+	}
+
+	void ParseError::locate(std::string_view source)
+	{
+		std::string_view before = source.substr(0, offset);
+		std::size_t lineStart = before.rfind('\n');
+
+		line = (int)countNewlines(before) + 1;
+		column = lineStart == std::string_view::npos ? offset + 1 : offset - lineStart;
+	}
+
+	std::string ParseError::message() const
+	{
+		switch (kind)
+		{
+		case Kind::None:
+			return "No error";
+
+		case Kind::UnexpectedEnd:
+			return std::format("Json string unexpectedly ended (line {}, column {})", line, column);
+
+		case Kind::TrailingContent:
+			return std::format("Json string unexpectedly continued (line {}, column {}) after first object", line, column);
+
+		case Kind::UnknownToken:
+			return std::format("Unknown token at line {}, column {}", line, column);
+
+		case Kind::UnknownCharacter:
+			return std::format("Unknown character at line {}, column {}", line, column);
+
+		case Kind::MalformedString:
+			return std::format("Malformed escape or invalid UTF-8 in string on line {}, column {}", line, column);
+
+		case Kind::MalformedNumber:
+			return std::format("Number on line {}, column {} is malformed", line, column);
+
+		case Kind::NumberOutOfRange:
+			return std::format("Number on line {}, column {} is out of range", line, column);
+
+		case Kind::MalformedKey:
+			return std::format("Missing or malformed key for dictionary on line {}, column {}", line, column);
+
+		case Kind::ExpectedColon:
+			return std::format("Expected a ':' on line {}, column {}", line, column);
+
+		case Kind::MissingArrayEnd:
+			return std::format("Array does not have an ending bracket on line {}, column {}", line, column);
+
+		case Kind::MissingDictionaryEnd:
+			return std::format("Dictionary did not have an ending bracket on line {}, column {}", line, column);
+
+		case Kind::TooDeep:
+			return std::format("Json string is nested too deeply on line {}, column {}", line, column);
+
+		case Kind::TooLarge:
+			return "Json string is too large";
+
+		case Kind::UnexpectedType:
+			return std::format("Value on line {}, column {} is not of the expected type", line, column);
+
+		case Kind::SchemaViolation:
+			return std::format("Value on line {}, column {} does not match the schema", line, column);
+		}
+
+		return "Unknown error";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,842 @@
+#include "Query.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+#include "Grammar.h"
+#include "Lexer.h"
+#include "ParseError.h"
+#include "StringUtils.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Jsonify
+{
+	namespace
+	{
+		constexpr std::size_t npos = (std::size_t)-1;
+
+		//each thread gets at least this much of the input, smaller inputs use fewer threads
+		constexpr std::size_t minPartition = 256 * 1024;
+
+		//same rules as the pointers of JsonPatch
+		std::vector<std::string> parsePointer(const std::string& pointer)
+		{
+			std::vector<std::string> res;
+
+			if (pointer.empty() || pointer[0] != '/') throw std::runtime_error(std::format("Json pointer \"{}\" does not start with '/'", pointer));
+
+			for (std::size_t i = 0; i < pointer.size(); i++)
+			{
+				if (pointer[i] == '/')
+				{
+					res.emplace_back();
+				}
+				else if (pointer[i] != '~')
+				{
+					res.back().push_back(pointer[i]);
+				}
+				else if (i + 1 < pointer.size() && (pointer[i + 1] == '0' || pointer[i + 1] == '1'))
+				{
+					res.back().push_back(pointer[++i] == '0' ? '~' : '/');
+				}
+				else
+				{
+					throw std::runtime_error(std::format("Json pointer \"{}\" has a malformed escape", pointer));
+				}
+			}
+
+			return res;
+		}
+
+		class MappedFile
+		{
+		public:
+			explicit MappedFile(const std::string& path)
+			{
+#ifdef _WIN32
+				file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+				if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(std::format("Unable to open {}", path));
+
+				LARGE_INTEGER fileSize;
+				if (!GetFileSizeEx(file, &fileSize)) throw std::runtime_error(std::format("Unable to read the size of {}", path));
+
+				size = (std::size_t)fileSize.QuadPart;
+
+				//empty files cannot be mapped
+				if (size == 0) return;
+
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (!mapping) throw std::runtime_error(std::format("Unable to map {}", path));
+
+				data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				if (!data) throw std::runtime_error(std::format("Unable to map {}", path));
+#else
+				file = open(path.c_str(), O_RDONLY);
+				if (file < 0) throw std::runtime_error(std::format("Unable to open {}", path));
+
+				struct stat info;
+				if (fstat(file, &info) != 0) throw std::runtime_error(std::format("Unable to read the size of {}", path));
+
+				size = (std::size_t)info.st_size;
+
+				//empty files cannot be mapped
+				if (size == 0) return;
+
+				void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+				if (mapped == MAP_FAILED) throw std::runtime_error(std::format("Unable to map {}", path));
+
+				data = (const char*)mapped;
+
+				//every thread reads its part front to back
+				madvise(mapped, size, MADV_SEQUENTIAL);
+#endif
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			std::string_view getText() const
+			{
+				return std::string_view(data, data ? size : 0);
+			}
+
+			~MappedFile()
+			{
+#ifdef _WIN32
+				if (data) UnmapViewOfFile(data);
+				if (mapping) CloseHandle(mapping);
+				if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+				if (data) munmap((void*)data, size);
+				if (file >= 0) close(file);
+#endif
+			}
+
+		private:
+			const char* data = nullptr;
+			std::size_t size = 0;
+
+#ifdef _WIN32
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = nullptr;
+#else
+			int file = -1;
+#endif
+		};
+
+		//the fields requested, merged into a tree of keys
+		struct PathNode
+		{
+			std::unordered_map<std::string, std::uint32_t, JsonValue::KeyHash, JsonValue::KeyEqual> children;
+			std::size_t field = npos;
+		};
+
+		struct Accumulator
+		{
+			double sum = 0;
+			double min = std::numeric_limits<double>::infinity();
+			double max = -std::numeric_limits<double>::infinity();
+			std::uint64_t count = 0;
+
+			void merge(const Accumulator& other)
+			{
+				sum += other.sum;
+				min = std::min(min, other.min);
+				max = std::max(max, other.max);
+				count += other.count;
+			}
+		};
+
+		struct Partial
+		{
+			std::uint64_t rows = 0;
+			std::vector<Accumulator> accumulators;
+		};
+
+		//group keys are tagged with their type so equal text of different types stays apart
+		typedef std::unordered_map<std::string, Partial, JsonValue::KeyHash, JsonValue::KeyEqual> Groups;
+
+		enum GroupTag : char
+		{
+			NumberTag = 'n',
+			StringTag = 's',
+			BooleanTag = 'b',
+			NullTag = 'z',
+		};
+	}
+
+	//reads the lines of one partition, one per thread
+	class Query::Scanner
+	{
+	public:
+		Scanner(const Query& query, const std::vector<PathNode>& paths)
+			: query(query), paths(paths), values(query.fields.size())
+		{
+		}
+
+		//false on the first malformed line unless they are skipped, error.offset is then relative to text
+		bool scan(std::string_view text, std::size_t base, const std::atomic<bool>& stop, ParseError& error)
+		{
+			std::size_t start = 0;
+
+			while (start < text.size() && !stop.load(std::memory_order_relaxed))
+			{
+				const char* newline = (const char*)std::memchr(text.data() + start, '\n', text.size() - start);
+				std::size_t end = newline ? newline - text.data() : text.size();
+
+				if (!scanLine(text.substr(start, end - start), error))
+				{
+					if (!query.settings.skipMalformed)
+					{
+						error.offset += base + start;
+
+						return false;
+					}
+
+					malformed++;
+				}
+
+				start = end + 1;
+			}
+
+			return true;
+		}
+
+		Groups groups;
+		std::uint64_t malformed = 0;
+
+	private:
+		//the last value read for a field, it is only set for the line in generation
+		struct Value
+		{
+			std::uint64_t generation = 0;
+
+			JsonValue::Type type;
+			double number;
+			std::string_view text;
+
+			std::string unescaped;
+		};
+
+		bool scanLine(std::string_view line, ParseError& error)
+		{
+			generation++;
+
+			this->line = line;
+			lexer.reset(line);
+
+			//blank lines hold no row
+			if (lexer.nextToken().type == Token::Type::Eof) return true;
+
+			bool read = lexer.readToken().isChar('{') ? readDictionary(0, 0, error) : skipValue(0, error);
+
+			if (read && !lexer.isEnd())
+				read = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
+
+			if (!read) return false;
+
+			for (const Filter& filter : query.filters)
+			{
+				if (!matches(filter)) return true;
+			}
+
+			addRow();
+
+			return true;
+		}
+
+		//called with the opening bracket current and leaves the token after the closing one current
+		bool readDictionary(std::uint32_t node, std::size_t depth, ParseError& error)
+		{
+			if (depth >= query.settings.maxDepth)
+				return error.fail(ParseError::Kind::TooDeep, lexer.readToken());
+
+			if (lexer.nextToken().isChar('}'))
+			{
+				lexer.nextToken();
+
+				return true;
+			}
+
+			while (true)
+			{
+				const Token& tokKey = lexer.readToken();
+
+				if (tokKey.type != Token::Type::String)
+					return error.fail(ParseError::Kind::MalformedKey, tokKey);
+
+				std::string_view key = tokKey.rawValue;
+
+				if (key.find('\\') != std::string_view::npos)
+				{
+					unescaped.clear();
+
+					if (!unescapeString(tokKey.rawValue, unescaped))
+						return error.fail(ParseError::Kind::MalformedString, tokKey);
+
+					key = unescaped;
+				}
+
+				const PathNode& parent = paths[node];
+				auto it = parent.children.find(key);
+
+				if (!lexer.nextToken().isChar(':'))
+					return error.fail(ParseError::Kind::ExpectedColon, lexer.readToken());
+
+				lexer.nextToken();
+
+				if (it == parent.children.end())
+				{
+					if (!skipValue(depth + 1, error)) return false;
+				}
+				else
+				{
+					const PathNode& child = paths[it->second];
+
+					if (child.field != npos && !capture(values[child.field], error)) return false;
+
+					bool read = !child.children.empty() && lexer.readToken().isChar('{') ? readDictionary(it->second, depth + 1, error) : skipValue(depth + 1, error);
+					if (!read) return false;
+				}
+
+				if (lexer.readToken().isChar(','))
+				{
+					lexer.nextToken();
+					continue;
+				}
+
+				if (lexer.readToken().isChar('}'))
+				{
+					lexer.nextToken();
+
+					return true;
+				}
+
+				if (lexer.isEnd())
+					return error.fail(ParseError::Kind::UnexpectedEnd, lexer.readToken());
+
+				return error.fail(ParseError::Kind::MissingDictionaryEnd, lexer.readToken());
+			}
+		}
+
+		//records the current token as the value of a field, leaving it to be read or skipped
+		bool capture(Value& value, ParseError& error)
+		{
+			const Token& tok = lexer.readToken();
+
+			value.generation = generation;
+
+			switch (tok.type)
+			{
+			case Token::Type::Number:
+			{
+				if (!isNumberLiteral(tok.rawValue))
+					return error.fail(ParseError::Kind::MalformedNumber, tok);
+
+				if (!toNumber(tok, value.number, error)) return false;
+
+				value.type = JsonValue::Type::Number;
+				break;
+			}
+
+			case Token::Type::String:
+				value.type = JsonValue::Type::String;
+				value.text = tok.rawValue;
+
+				if (value.text.find('\\') != std::string_view::npos)
+				{
+					value.unescaped.clear();
+
+					if (!unescapeString(tok.rawValue, value.unescaped))
+						return error.fail(ParseError::Kind::MalformedString, tok);
+
+					value.text = value.unescaped;
+				}
+				else if (!isValidUtf8(value.text))
+				{
+					return error.fail(ParseError::Kind::MalformedString, tok);
+				}
+				break;
+
+			case Token::Type::Boolean:
+				value.type = JsonValue::Type::Boolean;
+				value.number = tok.rawValue == "true";
+				break;
+
+			case Token::Type::Null:
+				value.type = JsonValue::Type::Null;
+				break;
+
+			default:
+				if (tok.isChar('{'))
+					value.type = JsonValue::Type::Dictionary;
+				else if (tok.isChar('['))
+					value.type = JsonValue::Type::Array;
+				else
+					value.generation = 0;
+				break;
+			}
+
+			return true;
+		}
+
+		//values nobody asked for are stepped over by their brackets and strings alone, without lexing what is inside
+		bool skipValue(std::size_t depth, ParseError& error)
+		{
+			const Token& tok = lexer.readToken();
+
+			switch (tok.type)
+			{
+			case Token::Type::Null:
+			case Token::Type::Boolean:
+			case Token::Type::Number:
+			case Token::Type::String:
+				lexer.nextToken();
+				return true;
+
+			case Token::Type::Eof:
+				return error.fail(ParseError::Kind::UnexpectedEnd, tok);
+
+			case Token::Type::Char:
+				if (tok.isChar('[') || tok.isChar('{')) break;
+
+				return error.fail(ParseError::Kind::UnknownCharacter, tok);
+
+			default:
+				return error.fail(ParseError::Kind::UnknownToken, tok);
+			}
+
+			skipped.clear();
+
+			for (std::size_t i = tok.location.start; i < line.size(); i++)
+			{
+				char c = line[i];
+
+				if (c == '"')
+				{
+					i = findStringEnd(line, i + 1);
+
+					if (i == std::string_view::npos)
+					{
+						error.kind = ParseError::Kind::MalformedString;
+						error.offset = line.size();
+
+						return false;
+					}
+				}
+				else if (c == '[' || c == '{')
+				{
+					if (depth + skipped.size() >= query.settings.maxDepth)
+					{
+						error.kind = ParseError::Kind::TooDeep;
+						error.offset = i;
+
+						return false;
+					}
+
+					skipped.push_back(c == '[');
+				}
+				else if (c == ']' || c == '}')
+				{
+					if (skipped.back() != (c == ']'))
+					{
+						error.kind = skipped.back() ? ParseError::Kind::MissingArrayEnd : ParseError::Kind::MissingDictionaryEnd;
+						error.offset = i;
+
+						return false;
+					}
+
+					skipped.pop_back();
+
+					if (skipped.empty())
+					{
+						lexer.seek(i + 1);
+
+						return true;
+					}
+				}
+			}
+
+			error.kind = ParseError::Kind::UnexpectedEnd;
+			error.offset = line.size();
+
+			return false;
+		}
+
+		bool matches(const Filter& filter) const
+		{
+			const Value& value = values[filter.field];
+			bool present = value.generation == generation;
+
+			if (filter.compare == Compare::Exists) return present;
+			if (!present) return filter.compare == Compare::NotEqual;
+
+			const JsonValue& operand = filter.operand;
+			int order;
+
+			if (value.type == JsonValue::Type::Number && operand.isNumber())
+			{
+				order = value.number < filter.number ? -1 : value.number > filter.number ? 1 : 0;
+			}
+			else if (value.type == JsonValue::Type::String && operand.isString())
+			{
+				order = value.text.compare(filter.text);
+				order = order < 0 ? -1 : order > 0 ? 1 : 0;
+			}
+			else if (value.type == JsonValue::Type::Boolean && operand.isBoolean())
+			{
+				order = (value.number != 0) == operand.as<bool>() ? 0 : 1;
+
+				if (filter.compare != Compare::Equal && filter.compare != Compare::NotEqual) return false;
+			}
+			else if (value.type == JsonValue::Type::Null && operand.isNull())
+			{
+				order = 0;
+
+				if (filter.compare != Compare::Equal && filter.compare != Compare::NotEqual) return false;
+			}
+			else
+			{
+				//different types are only ever unequal
+				return filter.compare == Compare::NotEqual;
+			}
+
+			switch (filter.compare)
+			{
+			case Compare::Equal: return order == 0;
+			case Compare::NotEqual: return order != 0;
+			case Compare::Less: return order < 0;
+			case Compare::LessEqual: return order <= 0;
+			case Compare::Greater: return order > 0;
+			case Compare::GreaterEqual: return order >= 0;
+			default: return false;
+			}
+		}
+
+		void addRow()
+		{
+			groupKey.clear();
+
+			if (query.group != npos)
+			{
+				const Value& value = values[query.group];
+
+				if (value.generation != generation)
+				{
+					groupKey.push_back(NullTag);
+				}
+				else if (value.type == JsonValue::Type::Number)
+				{
+					//negative zero groups with zero
+					double number = value.number == 0 ? 0 : value.number;
+
+					groupKey.push_back(NumberTag);
+					groupKey.append((const char*)&number, sizeof(number));
+				}
+				else if (value.type == JsonValue::Type::String)
+				{
+					groupKey.push_back(StringTag);
+					groupKey.append(value.text);
+				}
+				else if (value.type == JsonValue::Type::Boolean)
+				{
+					groupKey.push_back(BooleanTag);
+					groupKey.push_back(value.number != 0 ? '1' : '0');
+				}
+				else
+				{
+					groupKey.push_back(NullTag);
+				}
+			}
+
+			auto it = groups.find(std::string_view(groupKey));
+
+			if (it == groups.end())
+			{
+				it = groups.try_emplace(groupKey).first;
+				it->second.accumulators.resize(query.outputs.size());
+			}
+
+			Partial& partial = it->second;
+			partial.rows++;
+
+			for (std::size_t i = 0; i < query.outputs.size(); i++)
+			{
+				const Value& value = values[query.outputs[i].field];
+				Accumulator& accumulator = partial.accumulators[i];
+
+				if (value.generation != generation) continue;
+
+				if (query.outputs[i].aggregate == Aggregate::Count)
+				{
+					accumulator.count++;
+				}
+				else if (value.type == JsonValue::Type::Number)
+				{
+					accumulator.sum += value.number;
+					accumulator.min = std::min(accumulator.min, value.number);
+					accumulator.max = std::max(accumulator.max, value.number);
+					accumulator.count++;
+				}
+			}
+		}
+
+		const Query& query;
+		const std::vector<PathNode>& paths;
+
+		Lexer lexer;
+		std::string_view line;
+
+		std::vector<Value> values;
+		std::uint64_t generation = 0;
+
+		//brackets open while skipping, true for arrays
+		std::vector<bool> skipped;
+
+		std::string unescaped;
+		std::string groupKey;
+	};
+
+	Query::Query()
+		: settings(), group(npos)
+	{
+	}
+
+	Query::Query(Settings settings)
+		: settings(settings), group(npos)
+	{
+	}
+
+	Query& Query::where(const std::string& field, Compare compare, const JsonValue& operand)
+	{
+		Filter filter;
+		filter.field = addField(field);
+		filter.compare = compare;
+		filter.operand = operand;
+
+		if (operand.isString()) filter.text = operand.as<std::string>();
+		if (operand.isNumber()) filter.number = operand.as<double>();
+
+		filters.push_back(std::move(filter));
+
+		return *this;
+	}
+
+	Query& Query::groupBy(const std::string& field)
+	{
+		group = addField(field);
+
+		return *this;
+	}
+
+	Query& Query::aggregate(Aggregate aggregate, const std::string& field)
+	{
+		outputs.push_back({ addField(field), aggregate });
+
+		return *this;
+	}
+
+	QueryResult Query::runFile(const std::string& path) const
+	{
+		MappedFile file(path);
+
+		return run(file.getText());
+	}
+
+	QueryResult Query::run(std::string_view text) const
+	{
+		std::vector<PathNode> paths(1);
+
+		for (std::size_t i = 0; i < fields.size(); i++)
+		{
+			std::uint32_t node = 0;
+
+			for (const std::string& key : fields[i])
+			{
+				auto it = paths[node].children.find(key);
+
+				if (it == paths[node].children.end())
+				{
+					it = paths[node].children.try_emplace(key, (std::uint32_t)paths.size()).first;
+					paths.emplace_back();
+				}
+
+				node = it->second;
+			}
+
+			paths[node].field = i;
+		}
+
+		std::size_t threads = settings.threads != 0 ? settings.threads : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+		threads = std::clamp<std::size_t>(text.size() / minPartition, 1, threads);
+
+		//partitions end after a newline, so no line is split between threads
+		std::vector<std::size_t> bounds = { 0 };
+
+		for (std::size_t i = 1; i < threads; i++)
+		{
+			std::size_t bound = std::max(text.size() * i / threads, bounds.back());
+			std::size_t newline = text.find('\n', bound);
+
+			bounds.push_back(newline == std::string_view::npos ? text.size() : newline + 1);
+		}
+
+		bounds.push_back(text.size());
+
+		std::vector<Scanner> scanners;
+		std::vector<ParseError> errors(threads);
+		std::vector<char> failed(threads, false);
+		std::atomic<bool> stop = false;
+
+		for (std::size_t i = 0; i < threads; i++)
+			scanners.emplace_back(*this, paths);
+
+		auto work = [&](std::size_t i)
+		{
+			std::string_view part = text.substr(bounds[i], bounds[i + 1] - bounds[i]);
+
+			if (!scanners[i].scan(part, bounds[i], stop, errors[i]))
+			{
+				failed[i] = true;
+				stop.store(true, std::memory_order_relaxed);
+			}
+		};
+
+		std::vector<std::thread> workers;
+
+		for (std::size_t i = 1; i < threads; i++)
+			workers.emplace_back(work, i);
+
+		work(0);
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		//the partitions are in order, so the first that failed has the earliest error
+		for (std::size_t i = 0; i < threads; i++)
+		{
+			if (failed[i])
+			{
+				errors[i].locate(text);
+
+				throw std::runtime_error(errors[i].message());
+			}
+		}
+
+		QueryResult result;
+		Groups merged;
+
+		for (Scanner& scanner : scanners)
+		{
+			result.malformed += scanner.malformed;
+
+			for (auto& [key, partial] : scanner.groups)
+			{
+				auto [it, inserted] = merged.try_emplace(key, std::move(partial));
+
+				if (inserted) continue;
+
+				it->second.rows += partial.rows;
+
+				for (std::size_t i = 0; i < outputs.size(); i++)
+					it->second.accumulators[i].merge(partial.accumulators[i]);
+			}
+		}
+
+		std::vector<std::pair<std::string_view, Partial*>> ordered;
+
+		for (auto& [key, partial] : merged)
+			ordered.push_back({ key, &partial });
+
+		std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b)
+		{
+			static const std::string_view tags = "nsbz";
+
+			if (a.first[0] != b.first[0]) return tags.find(a.first[0]) < tags.find(b.first[0]);
+
+			if (a.first[0] == NumberTag)
+			{
+				double x, y;
+				std::memcpy(&x, a.first.data() + 1, sizeof(x));
+				std::memcpy(&y, b.first.data() + 1, sizeof(y));
+
+				return x < y;
+			}
+
+			return a.first.substr(1) < b.first.substr(1);
+		});
+
+		for (auto& [key, partial] : ordered)
+		{
+			QueryResult::Group& res = result.groups.emplace_back();
+			res.rows = partial->rows;
+
+			switch (key[0])
+			{
+			case NumberTag:
+			{
+				double number;
+				std::memcpy(&number, key.data() + 1, sizeof(number));
+
+				res.key = number;
+				break;
+			}
+
+			case StringTag:
+				res.key = std::string(key.substr(1));
+				break;
+
+			case BooleanTag:
+				res.key = key[1] == '1';
+				break;
+			}
+
+			for (std::size_t i = 0; i < outputs.size(); i++)
+			{
+				const Accumulator& accumulator = partial->accumulators[i];
+				double nan = std::numeric_limits<double>::quiet_NaN();
+
+				switch (outputs[i].aggregate)
+				{
+				case Aggregate::Sum: res.values.push_back(accumulator.sum); break;
+				case Aggregate::Min: res.values.push_back(accumulator.count ? accumulator.min : nan); break;
+				case Aggregate::Max: res.values.push_back(accumulator.count ? accumulator.max : nan); break;
+				case Aggregate::Mean: res.values.push_back(accumulator.count ? accumulator.sum / accumulator.count : nan); break;
+				case Aggregate::Count: res.values.push_back((double)accumulator.count); break;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	std::size_t Query::addField(const std::string& pointer)
+	{
+		std::vector<std::string> path = parsePointer(pointer);
+
+		if (path.empty()) throw std::runtime_error("Query fields have to be inside the row, not the row itself");
+
+		auto it = std::find(fields.begin(), fields.end(), path);
+		if (it != fields.end()) return it - fields.begin();
+
+		fields.push_back(std::move(path));
+
+		return fields.size() - 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include "Schema.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+
+#include "Grammar.h"
+#include "StringUtils.h"
+
+namespace Jsonify
+{
+	namespace
+	{
+		std::size_t countCodePoints(std::string_view str)
+		{
+			std::size_t count = 0;
+
+			for (char c : str)
+			{
+				if (((unsigned char)c & 0xC0) != 0x80) count++;
+			}
+
+			return count;
+		}
+
+		std::size_t readCount(const JsonValue& value, std::string_view keyword)
+		{
+			if (!value.isNumber() || value.as<double>() < 0 || std::floor(value.as<double>()) != value.as<double>())
+				throw std::runtime_error(std::format("Schema keyword {} has to be a non-negative integer", keyword));
+
+			return (std::size_t)value.as<double>();
+		}
+
+		double readNumber(const JsonValue& value, std::string_view keyword)
+		{
+			if (!value.isNumber())
+				throw std::runtime_error(std::format("Schema keyword {} has to be a number", keyword));
+
+			return value.as<double>();
+		}
+	}
+
+	Schema::Schema(const JsonValue& schema)
+	{
+		nodes.resize(2);
+		nodes[reject].types = 0;
+
+		root = compile(schema, 0);
+	}
+
+	std::uint32_t Schema::compile(const JsonValue& schema, std::size_t depth)
+	{
+		static const std::string_view unsupported[] = {
+			"$ref", "$dynamicRef", "allOf", "anyOf", "oneOf", "not", "if", "then", "else",
+			"pattern", "patternProperties", "propertyNames", "dependencies", "dependentRequired", "dependentSchemas",
+			"multipleOf", "uniqueItems", "contains", "prefixItems", "additionalItems", "unevaluatedItems", "unevaluatedProperties",
+		};
+
+		if (depth > 512) throw std::runtime_error("Schema is nested too deeply");
+
+		if (schema.isBoolean()) return schema.as<bool>() ? accept : reject;
+
+		if (!schema.isDictionary()) throw std::runtime_error("Schema has to be a dictionary or a boolean");
+
+		Node node;
+
+		//draft 4 uses booleans for the exclusive bounds, later drafts use numbers, so they are combined once all are read
+		double exclusiveMinimum = -std::numeric_limits<double>::infinity();
+		double exclusiveMaximum = std::numeric_limits<double>::infinity();
+		const JsonValue* required = nullptr;
+		bool hasConst = false;
+		bool hasEnum = false;
+
+		for (const auto& [key, value] : schema)
+		{
+			if (std::find(std::begin(unsupported), std::end(unsupported), key) != std::end(unsupported))
+				throw std::runtime_error(std::format("Schema keyword {} is not supported", std::string_view(key)));
+
+			if (key == "type")
+			{
+				auto readType = [](const JsonValue& type) -> std::uint8_t
+				{
+					if (!type.isString()) throw std::runtime_error("Schema type has to be a string or an array of strings");
+
+					std::string name = type.as<std::string>();
+
+					if (name == "string") return String;
+					if (name == "number") return Number;
+					if (name == "integer") return Integer;
+					if (name == "object") return Dictionary;
+					if (name == "array") return Array;
+					if (name == "boolean") return Boolean;
+					if (name == "null") return Null;
+
+					throw std::runtime_error(std::format("Schema type {} is unknown", name));
+				};
+
+				if (value.isArray())
+				{
+					node.types = 0;
+
+					for (std::size_t i = 0; i < value.size(); i++)
+						node.types |= readType(value.get<JsonValue>(i));
+				}
+				else
+				{
+					node.types = readType(value);
+				}
+			}
+			else if (key == "enum")
+			{
+				if (!value.isArray()) throw std::runtime_error("Schema keyword enum has to be an array");
+
+				hasEnum = true;
+				node.restricted = true;
+
+				for (std::size_t i = 0; i < value.size(); i++)
+					allow(node, value.get<JsonValue>(i));
+			}
+			else if (key == "const")
+			{
+				hasConst = true;
+				node.restricted = true;
+
+				allow(node, value);
+			}
+			else if (key == "minimum")
+			{
+				node.minimum = std::max(node.minimum, readNumber(value, key));
+			}
+			else if (key == "maximum")
+			{
+				node.maximum = std::min(node.maximum, readNumber(value, key));
+			}
+			else if (key == "exclusiveMinimum")
+			{
+				if (value.isBoolean())
+					node.exclusiveMinimum = value.as<bool>();
+				else
+					exclusiveMinimum = readNumber(value, key);
+			}
+			else if (key == "exclusiveMaximum")
+			{
+				if (value.isBoolean())
+					node.exclusiveMaximum = value.as<bool>();
+				else
+					exclusiveMaximum = readNumber(value, key);
+			}
+			else if (key == "minLength")
+			{
+				node.minLength = readCount(value, key);
+			}
+			else if (key == "maxLength")
+			{
+				node.maxLength = readCount(value, key);
+			}
+			else if (key == "minItems")
+			{
+				node.minItems = readCount(value, key);
+			}
+			else if (key == "maxItems")
+			{
+				node.maxItems = readCount(value, key);
+			}
+			else if (key == "minProperties")
+			{
+				node.minProperties = readCount(value, key);
+			}
+			else if (key == "maxProperties")
+			{
+				node.maxProperties = readCount(value, key);
+			}
+			else if (key == "properties")
+			{
+				if (!value.isDictionary()) throw std::runtime_error("Schema keyword properties has to be a dictionary");
+
+				for (const auto& [name, property] : value)
+					node.properties[std::string(name)] = { compile(property, depth + 1), npos };
+			}
+			else if (key == "required")
+			{
+				if (!value.isArray()) throw std::runtime_error("Schema keyword required has to be an array");
+
+				required = &value;
+			}
+			else if (key == "additionalProperties")
+			{
+				node.additional = compile(value, depth + 1);
+			}
+			else if (key == "items")
+			{
+				//the tuple form of older drafts
+				if (value.isArray()) throw std::runtime_error("Schema keyword items is only supported with a single schema");
+
+				node.items = compile(value, depth + 1);
+			}
+		}
+
+		if (hasConst && hasEnum) throw std::runtime_error("Schema keywords enum and const are not supported together");
+
+		if (exclusiveMinimum >= node.minimum)
+		{
+			node.minimum = exclusiveMinimum;
+			node.exclusiveMinimum = true;
+		}
+
+		if (exclusiveMaximum <= node.maximum)
+		{
+			node.maximum = exclusiveMaximum;
+			node.exclusiveMaximum = true;
+		}
+
+		//required keys that have no schema of their own take any value
+		if (required)
+		{
+			for (std::size_t i = 0; i < required->size(); i++)
+			{
+				JsonValue name = required->get<JsonValue>(i);
+
+				if (!name.isString()) throw std::runtime_error("Schema keyword required has to hold strings");
+
+				Property& property = node.properties.try_emplace(name.as<std::string>(), Property{ accept, npos }).first->second;
+
+				if (property.required == npos) property.required = node.requiredCount++;
+			}
+		}
+
+		nodes.push_back(std::move(node));
+
+		return (std::uint32_t)nodes.size() - 1;
+	}
+
+	void Schema::allow(Node& node, const JsonValue& value)
+	{
+		switch (value.getType())
+		{
+		case JsonValue::Type::String:
+			node.allowedStrings.push_back(value.as<std::string>());
+			break;
+
+		case JsonValue::Type::Number:
+			node.allowedNumbers.push_back(value.as<double>());
+			break;
+
+		case JsonValue::Type::Boolean:
+			(value.as<bool>() ? node.allowedTrue : node.allowedFalse) = true;
+			break;
+
+		case JsonValue::Type::Null:
+			node.allowedNull = true;
+			break;
+
+		default:
+			throw std::runtime_error("Schema keywords enum and const only support strings, numbers, booleans and null");
+		}
+	}
+
+	SchemaValidator::SchemaValidator(const Schema& schema)
+		: schema(&schema), settings(), next(schema.root)
+	{
+	}
+
+	SchemaValidator::SchemaValidator(const Schema& schema, Settings settings)
+		: schema(&schema), settings(settings), next(schema.root)
+	{
+	}
+
+	bool SchemaValidator::validate(std::string_view in, ParseError& error)
+	{
+		//feeds the visits from the walk
+		struct Feeder
+		{
+			SchemaValidator& validator;
+
+			//only strings with escapes are unescaped
+			bool decode(const Token& tok, std::string_view& str, ParseError& error)
+			{
+				str = tok.rawValue;
+
+				if (str.find('\\') != std::string_view::npos)
+				{
+					validator.unescaped.clear();
+
+					if (!unescapeString(tok.rawValue, validator.unescaped))
+						return error.fail(ParseError::Kind::MalformedString, tok);
+
+					str = validator.unescaped;
+				}
+				else if (!isValidUtf8(str))
+				{
+					return error.fail(ParseError::Kind::MalformedString, tok);
+				}
+
+				return true;
+			}
+
+			bool scalar(const Token& tok, ParseError& error)
+			{
+				bool valid;
+
+				switch (tok.type)
+				{
+				case Token::Type::Null:
+					valid = validator.visitNull();
+					break;
+
+				case Token::Type::Boolean:
+					valid = validator.visitBoolean(tok.rawValue == "true");
+					break;
+
+				case Token::Type::String:
+				{
+					std::string_view str;
+
+					if (!decode(tok, str, error)) return false;
+
+					valid = validator.visitString(str);
+					break;
+				}
+
+				default:
+				{
+					double num;
+
+					if (!toNumber(tok, num, error)) return false;
+
+					valid = validator.visitNumber(num);
+					break;
+				}
+				}
+
+				return valid || error.fail(ParseError::Kind::SchemaViolation, tok);
+			}
+
+			bool key(const Token& tok, ParseError& error)
+			{
+				std::string_view key;
+
+				if (!decode(tok, key, error)) return false;
+
+				return validator.visitKey(key) || error.fail(ParseError::Kind::SchemaViolation, tok);
+			}
+
+			bool beginContainer(bool isArray, const Token& tok, ParseError& error)
+			{
+				return (isArray ? validator.beginArray() : validator.beginDictionary()) || error.fail(ParseError::Kind::SchemaViolation, tok);
+			}
+
+			bool endContainer(bool, const Token& tok, ParseError& error)
+			{
+				return validator.endContainer() || error.fail(ParseError::Kind::SchemaViolation, tok);
+			}
+		};
+
+		reset();
+
+		lexer.reset(in);
+		lexer.nextToken();
+
+		Feeder feeder = { *this };
+		bool valid = walkValue(lexer, feeder, open, settings.maxDepth, error);
+
+		if (valid && !lexer.isEnd())
+			valid = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
+
+		if (!valid)
+		{
+			error.locate(in);
+
+			return false;
+		}
+
+		error = ParseError();
+
+		return true;
+	}
+
+	void SchemaValidator::reset()
+	{
+		stack.clear();
+		seen.clear();
+
+		next = schema->root;
+	}
+
+	bool SchemaValidator::visitNull()
+	{
+		std::uint32_t node;
+		if (!enter(Schema::Null, node)) return false;
+
+		const Schema::Node& rules = schema->nodes[node];
+
+		return !rules.restricted || rules.allowedNull;
+	}
+
+	bool SchemaValidator::visitBoolean(bool b)
+	{
+		std::uint32_t node;
+		if (!enter(Schema::Boolean, node)) return false;
+
+		const Schema::Node& rules = schema->nodes[node];
+
+		return !rules.restricted || (b ? rules.allowedTrue : rules.allowedFalse);
+	}
+
+	bool SchemaValidator::visitNumber(double n)
+	{
+		std::uint32_t node;
+		if (!enter(Schema::Number, node)) return false;
+
+		const Schema::Node& rules = schema->nodes[node];
+
+		if (!(rules.types & Schema::Number) && std::floor(n) != n) return false;
+
+		if (rules.exclusiveMinimum ? n <= rules.minimum : n < rules.minimum) return false;
+		if (rules.exclusiveMaximum ? n >= rules.maximum : n > rules.maximum) return false;
+
+		return !rules.restricted || std::find(rules.allowedNumbers.begin(), rules.allowedNumbers.end(), n) != rules.allowedNumbers.end();
+	}
+
+	bool SchemaValidator::visitString(std::string_view str)
+	{
+		std::uint32_t node;
+		if (!enter(Schema::String, node)) return false;
+
+		const Schema::Node& rules = schema->nodes[node];
+
+		//every code point takes at least one and at most four bytes, so most strings are decided by their size
+		if (str.size() < rules.minLength || str.size() / 4 > rules.maxLength)
+			return false;
+
+		if (str.size() > rules.maxLength || str.size() / 4 < rules.minLength)
+		{
+			std::size_t length = countCodePoints(str);
+
+			if (length < rules.minLength || length > rules.maxLength) return false;
+		}
+
+		return !rules.restricted || std::find(rules.allowedStrings.begin(), rules.allowedStrings.end(), str) != rules.allowedStrings.end();
+	}
+
+	bool SchemaValidator::beginArray()
+	{
+		std::uint32_t node;
+		if (!enter(Schema::Array, node)) return false;
+
+		stack.push_back({ node, true, 0, seen.size() });
+
+		return true;
+	}
+
+	bool SchemaValidator::beginDictionary()
+	{
+		std::uint32_t node;
+		if (!enter(Schema::Dictionary, node)) return false;
+
+		stack.push_back({ node, false, 0, seen.size() });
+		seen.resize(seen.size() + (schema->nodes[node].requiredCount + 63) / 64);
+
+		return true;
+	}
+
+	bool SchemaValidator::visitKey(std::string_view key)
+	{
+		Frame& frame = stack.back();
+		const Schema::Node& rules = schema->nodes[frame.node];
+
+		if (++frame.count > rules.maxProperties) return false;
+
+		auto it = rules.properties.find(key);
+
+		if (it == rules.properties.end())
+		{
+			next = rules.additional;
+
+			return next != Schema::reject;
+		}
+
+		next = it->second.node;
+
+		if (it->second.required != Schema::npos)
+			seen[frame.seen + it->second.required / 64] |= std::uint64_t(1) << (it->second.required % 64);
+
+		return true;
+	}
+
+	bool SchemaValidator::endContainer()
+	{
+		Frame frame = stack.back();
+		const Schema::Node& rules = schema->nodes[frame.node];
+
+		stack.pop_back();
+
+		if (frame.isArray) return frame.count >= rules.minItems;
+
+		std::size_t found = 0;
+
+		for (std::size_t i = frame.seen; i < seen.size(); i++)
+			found += std::popcount(seen[i]);
+
+		seen.resize(frame.seen);
+
+		return frame.count >= rules.minProperties && found == rules.requiredCount;
+	}
+
+	bool SchemaValidator::enter(std::uint8_t type, std::uint32_t& node)
+	{
+		node = next;
+
+		if (!stack.empty() && stack.back().isArray)
+		{
+			Frame& frame = stack.back();
+			const Schema::Node& array = schema->nodes[frame.node];
+
+			if (++frame.count > array.maxItems) return false;
+
+			node = array.items;
+		}
+
+		std::uint8_t types = schema->nodes[node].types;
+
+		return (types & type) != 0 || (type == Schema::Number && (types & Schema::Integer) != 0);
+	}
+}
\ No newline at end of file
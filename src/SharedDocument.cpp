@@ -0,0 +1,79 @@
+#include "SharedDocument.h"
+
+namespace Jsonify
+{
+	//versions start at 1, so the first get always loads
+	SharedDocument::Reader::Reader(const SharedDocument& shared)
+		: shared(&shared), version(0)
+	{
+	}
+
+	const FrozenDocument& SharedDocument::Reader::get()
+	{
+		std::uint64_t current = shared->version.load(std::memory_order_acquire);
+
+		if (current != version)
+		{
+			//the document loaded can only be this version or a newer one, which at worst costs one more refresh
+			version = current;
+			document = shared->document.load(std::memory_order_acquire);
+		}
+
+		return *document;
+	}
+
+	SharedDocument::SharedDocument()
+		: SharedDocument(StringReader::Settings())
+	{
+	}
+
+	SharedDocument::SharedDocument(StringReader::Settings settings)
+		: settings(settings), document(std::make_shared<const FrozenDocument>(JsonValue())), version(1)
+	{
+	}
+
+	void SharedDocument::publish(const JsonValue& value)
+	{
+		publish(std::make_shared<const FrozenDocument>(value));
+	}
+
+	void SharedDocument::publish(std::shared_ptr<const FrozenDocument> document)
+	{
+		if (!document) throw std::runtime_error("Unable to publish an empty document");
+
+		this->document.store(std::move(document), std::memory_order_release);
+		version.fetch_add(1, std::memory_order_release);
+	}
+
+	void SharedDocument::publishText(std::string_view in)
+	{
+		JsonValue value;
+
+		StringReader reader(settings);
+		reader.read(in, value);
+
+		publish(value);
+	}
+
+	bool SharedDocument::tryPublishText(std::string_view in, ParseError& error)
+	{
+		JsonValue value;
+
+		StringReader reader(settings);
+		if (!reader.tryRead(in, value, error)) return false;
+
+		publish(value);
+
+		return true;
+	}
+
+	std::shared_ptr<const FrozenDocument> SharedDocument::load() const
+	{
+		return document.load(std::memory_order_acquire);
+	}
+
+	std::uint64_t SharedDocument::getVersion() const
+	{
+		return version.load(std::memory_order_acquire);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "StreamReader.h"
+
+namespace Jsonify
+{
+	namespace
+	{
+		inline bool isWhitespace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+
+		//finds where each value ends, each generator has its own so they never share what they have seen
+		struct Scanner
+		{
+			//where findEnd continues from, and what it has seen of the current value so far
+			std::size_t scanned = 0;
+			std::size_t depth = 0;
+			bool inString = false;
+			bool escaped = false;
+
+			//length of the value at the start of buffered once it is known to be complete, or npos
+			std::size_t findEnd(std::string_view buffered, bool eof);
+		};
+	}
+
+	StreamReader::StreamReader()
+		: settings()
+	{
+	}
+
+	StreamReader::StreamReader(Settings settings)
+		: settings(settings)
+	{
+	}
+
+	Generator<JsonValue> StreamReader::read(std::istream& in)
+	{
+		//each value is parsed over the last one, a failed read throws so nothing is lost by that
+		StringReader::Settings readerSettings = settings.reader;
+		readerSettings.inPlace = true;
+
+		StringReader reader(readerSettings);
+		JsonValue value;
+		ParseError error;
+
+		Scanner scanner;
+
+		std::string buffer;
+		std::size_t start = 0;
+		bool eof = false;
+
+		while (true)
+		{
+			while (start < buffer.size() && isWhitespace(buffer[start])) start++;
+
+			std::size_t length = start < buffer.size() ? scanner.findEnd(std::string_view(buffer).substr(start), eof) : std::string_view::npos;
+
+			if (length != std::string_view::npos)
+			{
+				if (!reader.tryRead(std::string_view(buffer).substr(start, length), value, error))
+					throw std::runtime_error(error.message());
+
+				start += length;
+				scanner = Scanner();
+
+				co_yield value;
+
+				continue;
+			}
+
+			if (eof) co_return;
+
+			//drop what was already parsed before reading more, so the buffer only ever holds one value
+			buffer.erase(0, start);
+			start = 0;
+
+			if (buffer.size() > settings.maxValueSize)
+			{
+				error.kind = ParseError::Kind::TooLarge;
+				throw std::runtime_error(error.message());
+			}
+
+			//take what the stream already holds, and only wait for a whole chunk when it holds nothing
+			//std::cin synced with stdio never reports what it holds, so it is always read a chunk at a time
+			std::size_t offset = buffer.size();
+			buffer.resize(offset + settings.chunkSize);
+
+			std::streamsize taken = in.readsome(buffer.data() + offset, settings.chunkSize);
+
+			if (taken == 0 && in)
+			{
+				in.read(buffer.data() + offset, settings.chunkSize);
+				taken = in.gcount();
+			}
+
+			buffer.resize(offset + taken);
+
+			if (taken == 0) eof = true;
+		}
+	}
+
+	//only tracks strings and nesting, the value is checked properly when it is parsed
+	std::size_t Scanner::findEnd(std::string_view buffered, bool eof)
+	{
+		for (; scanned < buffered.size(); scanned++)
+		{
+			char c = buffered[scanned];
+
+			if (inString)
+			{
+				if (escaped)
+					escaped = false;
+				else if (c == '\\')
+					escaped = true;
+				else if (c == '"')
+				{
+					inString = false;
+
+					if (depth == 0) return ++scanned;
+				}
+
+				continue;
+			}
+
+			switch (c)
+			{
+			case '"':
+			case '{':
+			case '[':
+				//ends a number or keyword that was not followed by whitespace
+				if (depth == 0 && scanned != 0) return scanned;
+
+				if (c == '"')
+					inString = true;
+				else
+					depth++;
+				break;
+
+			case '}':
+			case ']':
+				//a stray bracket is passed on for the parser to reject
+				if (depth == 0 || --depth == 0) return ++scanned;
+				break;
+
+			default:
+				if (depth == 0 && isWhitespace(c)) return scanned;
+				break;
+			}
+		}
+
+		//the last value can run up to the end of the stream
+		return eof ? buffered.size() : std::string_view::npos;
+	}
+}
\ No newline at end of file
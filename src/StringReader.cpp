@@ -1,177 +1,392 @@
 #include "StringReader.h"
 
-#include <format>
+#include "Grammar.h"
+#include "StringUtils.h"
 
 namespace Jsonify
 {
 	StringReader::StringReader()
+		: settings()
 	{
 	}
 
-	void StringReader::read(const std::string& in, JsonValue& value)
+	StringReader::StringReader(Settings settings)
+		: settings(settings)
 	{
-		Lexer lexer(in);
+		if (settings.schema) validator.emplace(*settings.schema);
+	}
+
+	void StringReader::read(std::string_view in, JsonValue& value)
+	{
+		ParseError error;
+
+		if (!tryRead(in, value, error))
+			throw std::runtime_error(error.message());
+	}
+
+	bool StringReader::tryRead(std::string_view in, JsonValue& value, ParseError& error)
+	{
+		if (settings.inPlace) return parseDocument(in, value, error);
+
+		//parsed apart and moved in once complete, on the same resource so the move takes the nodes as they are
+		JsonValue parsed(std::allocator_arg, value.get_allocator());
 
+		if (!parseDocument(in, parsed, error)) return false;
+
+		value = std::move(parsed);
+
+		return true;
+	}
+
+	bool StringReader::parseDocument(std::string_view in, JsonValue& value, ParseError& error)
+	{
+		lexer.reset(in);
 		lexer.nextToken();
 
-		JsonValue res = parseValue(lexer);
+		if (validator) validator->reset();
+
+		bool parsed = parseValue(value, error);
+
+		if (parsed && !lexer.isEnd())
+			parsed = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
+
+		if (!parsed)
+		{
+			for (Frame& frame : stack)
+				frame.recycled.clear();
+
+			value.setType(JsonValue::Type::Null);
+			error.locate(in);
+
+			return false;
+		}
 
-		if (!lexer.isEnd())
-			throw std::runtime_error(std::format("Json string unexpectedly continued (line {}) after first object", lexer.readToken().location.line));
+		error = ParseError();
+
+		return true;
+	}
+
+	bool StringReader::validate(std::string_view in)
+	{
+		ParseError error;
 
-		value = res;
+		return validate(in, error);
 	}
 
-	JsonValue StringReader::parseValue(Lexer& lexer)
+	bool StringReader::validate(std::string_view in, ParseError& error)
 	{
-		if (lexer.isEnd())
-			throw std::runtime_error("Json string unexpectedly ended when parsing value");
+		lexer.reset(in);
+		lexer.nextToken();
+
+		bool valid = validateValue(error);
 
-		const Token& tok = lexer.readToken();
+		if (valid && !lexer.isEnd())
+			valid = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
 
-		switch (tok.type)
+		if (!valid)
 		{
-		case Token::Type::Null:
-		case Token::Type::Boolean:
-			return parseKeyword(lexer);
+			error.locate(in);
+
+			return false;
+		}
 
-		case Token::Type::String:
-			return parseString(lexer);
+		error = ParseError();
 
-		case Token::Type::Number:
-			return parseNumber(lexer);
+		return true;
+	}
 
-		case Token::Type::Char:
+	//containers are tracked on an explicit stack so deeply nested input cannot overflow the call stack
+	bool StringReader::parseValue(JsonValue& value, ParseError& error)
+	{
+		//fills the values in place as the walk reports them
+		struct Builder
 		{
-			if (tok.rawValue.compare("[") == 0)
+			StringReader& reader;
+			JsonValue& root;
+			std::size_t depth = 0;
+
+			//taken by key just before its value is reported
+			JsonValue* member = nullptr;
+
+			JsonValue& slot()
 			{
-				return parseArray(lexer);
+				if (depth == 0) return root;
+
+				Frame& frame = reader.stack[depth - 1];
+
+				if (frame.container->type != JsonValue::Type::Array) return *member;
+
+				//mixed array, the rest is read into nodes
+				if (frame.container->packed)
+				{
+					frame.count = frame.container->p.values.size();
+					frame.container->unpack();
+				}
+
+				return reader.nextElement(frame);
 			}
-			else if (tok.rawValue.compare("{") == 0)
+
+			bool scalar(const Token& tok, ParseError& error)
 			{
-				return parseDictionary(lexer);
+				if (tok.type == Token::Type::Number && depth > 0 && reader.stack[depth - 1].container->packed)
+				{
+					double num;
+
+					if (!reader.parseNumber(num, tok, error)) return false;
+
+					reader.stack[depth - 1].container->p.values.push_back(num);
+
+					return true;
+				}
+
+				JsonValue& value = slot();
+
+				switch (tok.type)
+				{
+				case Token::Type::String:
+					return reader.parseString(value, tok, error);
+
+				case Token::Type::Number:
+					return reader.parseNumber(value, tok, error);
+
+				default:
+					return reader.parseKeyword(value, tok, error);
+				}
 			}
-			
-			throw std::runtime_error(std::format("Unknown character '{}' at line {}", tok.rawValue, tok.location.line));
-		}
 
-		default:
-			throw std::runtime_error(std::format("Unknown token \"{}\" at line {}", tok.rawValue, tok.location.line));
-		}
+			bool key(const Token& tok, ParseError& error)
+			{
+				Frame& frame = reader.stack[depth - 1];
+
+				if (!reader.parseKey(frame.key, tok, error)) return false;
+
+				member = &reader.nextMember(frame);
+
+				return true;
+			}
+
+			bool beginContainer(bool isArray, const Token& tok, ParseError& error)
+			{
+				if (reader.validator && !(isArray ? reader.validator->beginArray() : reader.validator->beginDictionary()))
+					return error.fail(ParseError::Kind::SchemaViolation, tok);
+
+				reader.openContainer(slot(), isArray, depth);
+				depth++;
+
+				return true;
+			}
+
+			bool endContainer(bool, const Token& tok, ParseError& error)
+			{
+				if (reader.validator && !reader.validator->endContainer())
+					return error.fail(ParseError::Kind::SchemaViolation, tok);
+
+				reader.closeContainer(reader.stack[--depth]);
+
+				return true;
+			}
+		};
+
+		Builder builder = { *this, value };
+
+		return walkValue(lexer, builder, open, settings.maxDepth, error);
 	}
 
-	JsonValue StringReader::parseKeyword(Lexer& lexer)
+	//called with the first token inside the container current
+	void StringReader::openContainer(JsonValue& container, bool isArray, std::size_t depth)
 	{
-		if (lexer.readToken().type == Token::Type::Boolean)
+		JsonValue::Type type = isArray ? JsonValue::Type::Array : JsonValue::Type::Dictionary;
+		bool packed = isArray && settings.packNumbers && !settings.rawNumbers && lexer.readToken().type == Token::Type::Number;
+
+		if (container.type != type || container.packed != packed) container.setType(JsonValue::Type::Null);
+
+		if (packed)
+		{
+			container.setPacked();
+			container.p.values.clear();
+		}
+		else
 		{
-			bool res = lexer.readToken().rawValue == "true";
+			container.setType(type);
+		}
 
-			lexer.nextToken();
+		if (depth == stack.size()) stack.emplace_back();
 
-			return res;
+		Frame& frame = stack[depth];
+		frame.container = &container;
+		frame.count = 0;
+
+		if (isArray) return;
+
+		//swapping and moving nodes between the tables needs them on the same resource
+		if (frame.recycled.get_allocator() != container.m.get_allocator())
+		{
+			frame.recycled.~unordered_map();
+			new (&frame.recycled) JsonValue::Map(container.m.get_allocator());
 		}
-		
-		lexer.nextToken();
 
-		return JsonValue();
+		//recycled is always left empty, so this takes the old entries and hands back an empty table
+		container.m.swap(frame.recycled);
 	}
-	
-	JsonValue StringReader::parseString(Lexer& lexer)
+
+	void StringReader::closeContainer(Frame& frame)
 	{
-		std::string res = std::string(lexer.readToken().rawValue);
+		if (frame.container->packed)
+			return;
 
-		lexer.nextToken();
+		if (frame.container->type == JsonValue::Type::Array)
+			frame.container->v.resize(frame.count);
+		else
+			frame.recycled.clear();
+	}
 
-		return res;
+	JsonValue& StringReader::nextElement(Frame& frame)
+	{
+		std::pmr::vector<JsonValue>& elements = frame.container->v;
+
+		if (frame.count++ < elements.size())
+			return elements[frame.count - 1];
+
+		return elements.emplace_back();
 	}
 
-	JsonValue StringReader::parseNumber(Lexer& lexer)
+	JsonValue& StringReader::nextMember(Frame& frame)
 	{
-		try
-		{
-			size_t sz;
-			double num = std::stod(std::string(lexer.readToken().rawValue), &sz);
-			
-			if (sz != lexer.readToken().rawValue.size())
-				throw std::runtime_error(std::format("Malformed number on line {}", lexer.readToken().location.line));
+		JsonValue::Map& members = frame.container->m;
 
-			lexer.nextToken();
+		auto node = frame.recycled.extract(frame.key);
+		if (!node.empty())
+			return members.insert(std::move(node)).position->second;
 
-			return num;
-		}
-		catch (const std::invalid_argument& ex)
-		{
-			throw std::runtime_error(std::format("Number on line {} is malformed ({})", lexer.readToken().location.line, ex.what()));
-		}
-		catch (const std::out_of_range& ex)
+		//a repeated key lands on the entry parsed first and overwrites it
+		return members.try_emplace(frame.key).first->second;
+	}
+
+	//the walk of parseValue with nothing built
+	bool StringReader::validateValue(ParseError& error)
+	{
+		struct Checker
 		{
-			throw std::runtime_error(std::format("Number on line {} is out of range ({})", lexer.readToken().location.line, ex.what()));
-		}
+			StringReader& reader;
+
+			bool scalar(const Token& tok, ParseError& error)
+			{
+				if (tok.type == Token::Type::String) return reader.checkString(tok, error);
+
+				//a number a read would turn away for its range is invalid here too
+				double num;
+
+				return tok.type != Token::Type::Number || reader.settings.rawNumbers || toNumber(tok, num, error);
+			}
+
+			bool key(const Token& tok, ParseError& error)
+			{
+				return reader.checkString(tok, error);
+			}
+
+			bool beginContainer(bool, const Token&, ParseError&)
+			{
+				return true;
+			}
+
+			bool endContainer(bool, const Token&, ParseError&)
+			{
+				return true;
+			}
+		};
+
+		Checker checker = { *this };
+
+		return walkValue(lexer, checker, open, settings.maxDepth, error);
 	}
 
-	JsonValue StringReader::parseArray(Lexer& lexer)
+	//strings without escapes only need their UTF-8 checked, which is much cheaper than decoding
+	bool StringReader::checkString(const Token& tok, ParseError& error)
 	{
-		lexer.nextToken();
+		bool valid = tok.rawValue.find('\\') == std::string_view::npos ? isValidUtf8(tok.rawValue) : validateString(tok.rawValue);
 
-		JsonValue arr;
-		arr.setType(JsonValue::Type::Array);
+		return valid || error.fail(ParseError::Kind::MalformedString, tok);
+	}
 
-		while (!lexer.isEnd() && lexer.readToken().rawValue.compare("]") != 0)
+	bool StringReader::parseKeyword(JsonValue& value, const Token& tok, ParseError& error)
+	{
+		if (tok.type == Token::Type::Boolean)
 		{
-			arr.push_back(parseValue(lexer));
+			bool b = tok.rawValue == "true";
 
-			if (lexer.isEnd() || lexer.readToken().rawValue.compare(",") != 0) break;
+			if (validator && !validator->visitBoolean(b))
+				return error.fail(ParseError::Kind::SchemaViolation, tok);
 
-			lexer.nextToken();
+			value = b;
 		}
+		else
+		{
+			if (validator && !validator->visitNull())
+				return error.fail(ParseError::Kind::SchemaViolation, tok);
 
-		if (lexer.isEnd())
-			throw std::runtime_error(std::format("Json string unexpectedly ended while parsing array"));
+			value = JsonValue();
+		}
 
-		if (lexer.readToken().rawValue.compare("]") != 0)
-			throw std::runtime_error(std::format("Array does not have an ending bracket on line {}", lexer.readToken().location.line));
-		
-		lexer.nextToken();
+		return true;
+	}
+	
+	bool StringReader::parseString(JsonValue& value, const Token& tok, ParseError& error)
+	{
+		if (value.type != JsonValue::Type::String) value.setType(JsonValue::Type::Null);
+		value.setType(JsonValue::Type::String);
 
-		return arr;
+		value.s.clear();
+
+		if (!unescapeString(tok.rawValue, value.s))
+			return error.fail(ParseError::Kind::MalformedString, tok);
+
+		if (validator && !validator->visitString(value.s))
+			return error.fail(ParseError::Kind::SchemaViolation, tok);
+
+		return true;
 	}
 
-	JsonValue StringReader::parseDictionary(Lexer& lexer)
+	bool StringReader::parseNumber(JsonValue& value, const Token& tok, ParseError& error)
 	{
-		lexer.nextToken();
+		if (settings.rawNumbers)
+		{
+			value.setRawNumber(tok.rawValue);
 
-		JsonValue dict;
-		dict.setType(JsonValue::Type::Dictionary);
+			if (validator && !validator->visitNumber(value.number()))
+				return error.fail(ParseError::Kind::SchemaViolation, tok);
 
-		while (!lexer.isEnd() && lexer.readToken().rawValue.compare("}") != 0)
-		{
-			const Token& tokKey = lexer.readToken();
-			
-			if (tokKey.type != Token::Type::String || tokKey.type == Token::Type::BrokenString)
-				throw std::runtime_error(std::format("Missing or malformed key for dictionary on line {}", tokKey.location.line));
+			return true;
+		}
 
-			std::string key = std::string(tokKey.rawValue);
-			
-			if (lexer.nextToken().type != Token::Type::Char || lexer.readToken().rawValue.compare(":") != 0)
-				throw std::runtime_error(std::format("Expected a ':' on line {}", lexer.readToken().location.line));
+		double num;
 
-			lexer.nextToken();
+		if (!parseNumber(num, tok, error)) return false;
 
-			dict[key] = parseValue(lexer);
+		value = num;
 
-			if (lexer.isEnd() || lexer.readToken().rawValue.compare(",") != 0) break;
+		return true;
+	}
 
-			lexer.nextToken();
-		}
+	bool StringReader::parseNumber(double& num, const Token& tok, ParseError& error)
+	{
+		if (!toNumber(tok, num, error)) return false;
 
-		if (lexer.isEnd())
-			throw std::runtime_error(std::format("Json string unexpectedly ended while parsing dictionary"));
+		if (validator && !validator->visitNumber(num))
+			return error.fail(ParseError::Kind::SchemaViolation, tok);
 
-		if (lexer.readToken().rawValue.compare("}") != 0)
-			throw std::runtime_error(std::format("Dictionary did not have an ending bracket on line {}", lexer.readToken().location.line));
+		return true;
+	}
 
-		lexer.nextToken();
+	bool StringReader::parseKey(std::pmr::string& key, const Token& tok, ParseError& error)
+	{
+		key.clear();
+
+		if (!unescapeString(tok.rawValue, key))
+			return error.fail(ParseError::Kind::MalformedString, tok);
+
+		if (validator && !validator->visitKey(key))
+			return error.fail(ParseError::Kind::SchemaViolation, tok);
 
-		return dict;
+		return true;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,513 @@
+#include "StringUtils.h"
+
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define JSONIFY_SSE2
+#include <emmintrin.h>
+#endif
+
+//SSE2 kernels, each returns a bitmask with one bit per byte of the 16 loaded from p
+#ifdef JSONIFY_SSE2
+inline __m128i loadChunk(const char* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+inline std::uint32_t maskEquals(__m128i chunk, char c)
+{
+	return (std::uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)));
+}
+
+//bytes below 0x20
+inline std::uint32_t maskControl(__m128i chunk)
+{
+	__m128i limit = _mm_set1_epi8(0x1F);
+
+	return (std::uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, limit), limit));
+}
+
+//bytes at or above 0x80
+inline std::uint32_t maskNonAscii(__m128i chunk)
+{
+	return (std::uint32_t)_mm_movemask_epi8(chunk);
+}
+#endif
+
+inline bool needsEscape(unsigned char c)
+{
+	return c == '"' || c == '\\' || c < 0x20;
+}
+
+//length of the UTF-8 sequence at p, 0 if it is malformed, overlong, a surrogate or above U+10FFFF
+inline std::size_t utf8SequenceLength(const unsigned char* p, std::size_t remaining)
+{
+	unsigned char c = p[0];
+
+	if (c < 0x80) return 1;
+
+	std::size_t length;
+	unsigned char min = 0x80, max = 0xBF;
+
+	if (c >= 0xC2 && c <= 0xDF)
+	{
+		length = 2;
+	}
+	else if (c >= 0xE0 && c <= 0xEF)
+	{
+		length = 3;
+
+		if (c == 0xE0) min = 0xA0;
+		if (c == 0xED) max = 0x9F;
+	}
+	else if (c >= 0xF0 && c <= 0xF4)
+	{
+		length = 4;
+
+		if (c == 0xF0) min = 0x90;
+		if (c == 0xF4) max = 0x8F;
+	}
+	else
+	{
+		return 0;
+	}
+
+	if (remaining < length) return 0;
+	if (p[1] < min || p[1] > max) return 0;
+
+	for (std::size_t i = 2; i < length; i++)
+	{
+		if (p[i] < 0x80 || p[i] > 0xBF) return 0;
+	}
+
+	return length;
+}
+
+template<typename Output>
+inline void appendUtf8(std::uint32_t codepoint, Output& out)
+{
+	if (codepoint < 0x80)
+	{
+		out.push_back((char)codepoint);
+	}
+	else if (codepoint < 0x800)
+	{
+		out.push_back((char)(0xC0 | (codepoint >> 6)));
+		out.push_back((char)(0x80 | (codepoint & 0x3F)));
+	}
+	else if (codepoint < 0x10000)
+	{
+		out.push_back((char)(0xE0 | (codepoint >> 12)));
+		out.push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+		out.push_back((char)(0x80 | (codepoint & 0x3F)));
+	}
+	else
+	{
+		out.push_back((char)(0xF0 | (codepoint >> 18)));
+		out.push_back((char)(0x80 | ((codepoint >> 12) & 0x3F)));
+		out.push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+		out.push_back((char)(0x80 | (codepoint & 0x3F)));
+	}
+}
+
+inline bool parseHex4(std::string_view raw, std::size_t at, std::uint32_t& res)
+{
+	if (at + 4 > raw.size()) return false;
+
+	res = 0;
+	for (std::size_t i = at; i < at + 4; i++)
+	{
+		char c = raw[i];
+		res <<= 4;
+
+		if (c >= '0' && c <= '9') res |= c - '0';
+		else if (c >= 'a' && c <= 'f') res |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') res |= c - 'A' + 10;
+		else return false;
+	}
+
+	return true;
+}
+
+//discards everything, for validating without decoding
+struct NullOutput
+{
+	void append(const char*, std::size_t)
+	{
+	}
+
+	void push_back(char)
+	{
+	}
+};
+
+//compares the decoded string against expected as it is produced, without storing it
+struct CompareOutput
+{
+	std::string_view expected;
+	std::size_t at = 0;
+	bool equal = true;
+
+	void append(const char* data, std::size_t length)
+	{
+		if (!equal) return;
+
+		equal = length <= expected.size() - at && std::memcmp(expected.data() + at, data, length) == 0;
+		at += length;
+	}
+
+	void push_back(char c)
+	{
+		equal = equal && at < expected.size() && expected[at] == c;
+		at++;
+	}
+};
+
+//decodes escapes and validates UTF-8, Output needs append(const char*, std::size_t) and push_back(char)
+template<typename Output>
+bool decodeString(std::string_view raw, Output& out)
+{
+	std::size_t i = 0;
+
+	while (i < raw.size())
+	{
+		std::size_t runEnd = i;
+
+#ifdef JSONIFY_SSE2
+		while (runEnd + 16 <= raw.size())
+		{
+			__m128i chunk = loadChunk(raw.data() + runEnd);
+			std::uint32_t mask = maskEquals(chunk, '\\') | maskNonAscii(chunk);
+
+			if (mask != 0)
+			{
+				runEnd += std::countr_zero(mask);
+				break;
+			}
+
+			runEnd += 16;
+		}
+#endif
+		while (runEnd < raw.size() && raw[runEnd] != '\\' && (unsigned char)raw[runEnd] < 0x80) runEnd++;
+
+		out.append(raw.data() + i, runEnd - i);
+		i = runEnd;
+
+		if (i == raw.size()) break;
+
+		if (raw[i] != '\\')
+		{
+			std::size_t length = utf8SequenceLength((const unsigned char*)raw.data() + i, raw.size() - i);
+			if (length == 0) return false;
+
+			out.append(raw.data() + i, length);
+			i += length;
+
+			continue;
+		}
+
+		if (i + 1 >= raw.size()) return false;
+
+		char escape = raw[i + 1];
+		i += 2;
+
+		switch (escape)
+		{
+		case '"': out.push_back('"'); break;
+		case '\\': out.push_back('\\'); break;
+		case '/': out.push_back('/'); break;
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+
+		case 'u':
+		{
+			std::uint32_t codepoint;
+			if (!parseHex4(raw, i, codepoint)) return false;
+
+			i += 4;
+
+			if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) return false;
+
+			if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+			{
+				std::uint32_t low;
+
+				if (i + 2 > raw.size() || raw[i] != '\\' || raw[i + 1] != 'u' || !parseHex4(raw, i + 2, low)) return false;
+				if (low < 0xDC00 || low > 0xDFFF) return false;
+
+				i += 6;
+				codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+			}
+
+			appendUtf8(codepoint, out);
+			break;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//end of the run starting at i that can be copied without escaping
+inline std::size_t findEscapeRunEnd(std::string_view str, std::size_t i)
+{
+#ifdef JSONIFY_SSE2
+	while (i + 16 <= str.size())
+	{
+		__m128i chunk = loadChunk(str.data() + i);
+		std::uint32_t mask = maskEquals(chunk, '"') | maskEquals(chunk, '\\') | maskControl(chunk);
+
+		if (mask != 0) return i + std::countr_zero(mask);
+
+		i += 16;
+	}
+#endif
+	while (i < str.size() && !needsEscape(str[i])) i++;
+
+	return i;
+}
+
+namespace Jsonify
+{
+	std::size_t findStringEnd(std::string_view source, std::size_t start)
+	{
+		std::size_t i = start;
+
+		while (i < source.size())
+		{
+#ifdef JSONIFY_SSE2
+			while (i + 16 <= source.size())
+			{
+				__m128i chunk = loadChunk(source.data() + i);
+				std::uint32_t mask = maskEquals(chunk, '"') | maskEquals(chunk, '\\') | maskControl(chunk);
+
+				if (mask != 0)
+				{
+					i += std::countr_zero(mask);
+					break;
+				}
+
+				i += 16;
+			}
+
+			if (i >= source.size()) break;
+#endif
+			unsigned char c = source[i];
+
+			if (c == '"') return i;
+			if (c < 0x20) return std::string_view::npos;
+
+			i += c == '\\' ? 2 : 1;
+		}
+
+		return std::string_view::npos;
+	}
+
+	bool unescapeString(std::string_view raw, std::string& out)
+	{
+		return decodeString(raw, out);
+	}
+
+	bool unescapeString(std::string_view raw, std::pmr::string& out)
+	{
+		return decodeString(raw, out);
+	}
+
+	bool validateString(std::string_view raw)
+	{
+		NullOutput out;
+
+		return decodeString(raw, out);
+	}
+
+	bool unescapedEquals(std::string_view raw, std::string_view str)
+	{
+		CompareOutput out = { str };
+
+		return decodeString(raw, out) && out.equal && out.at == str.size();
+	}
+
+	void escapeString(std::string_view str, std::string& out)
+	{
+		std::size_t offset = out.size();
+
+		out.resize(offset + escapedLength(str));
+		escapeString(str, out.data() + offset);
+	}
+
+	char* escapeString(std::string_view str, char* out)
+	{
+		static const char hex[] = "0123456789abcdef";
+
+		std::size_t i = 0;
+
+		while (i < str.size())
+		{
+			std::size_t runEnd = findEscapeRunEnd(str, i);
+
+			std::memcpy(out, str.data() + i, runEnd - i);
+			out += runEnd - i;
+			i = runEnd;
+
+			if (i == str.size()) break;
+
+			unsigned char c = str[i++];
+			*out++ = '\\';
+
+			switch (c)
+			{
+			case '"': *out++ = '"'; break;
+			case '\\': *out++ = '\\'; break;
+			case '\b': *out++ = 'b'; break;
+			case '\f': *out++ = 'f'; break;
+			case '\n': *out++ = 'n'; break;
+			case '\r': *out++ = 'r'; break;
+			case '\t': *out++ = 't'; break;
+
+			default:
+				std::memcpy(out, "u00", 3);
+				out[3] = hex[c >> 4];
+				out[4] = hex[c & 0xF];
+				out += 5;
+				break;
+			}
+		}
+
+		return out;
+	}
+
+	std::size_t escapedLength(std::string_view str)
+	{
+		std::size_t length = str.size();
+		std::size_t i = findEscapeRunEnd(str, 0);
+
+		while (i < str.size())
+		{
+			unsigned char c = str[i++];
+
+			switch (c)
+			{
+			case '"':
+			case '\\':
+			case '\b':
+			case '\f':
+			case '\n':
+			case '\r':
+			case '\t':
+				length += 1;
+				break;
+
+			default:
+				length += 5;
+				break;
+			}
+
+			i = findEscapeRunEnd(str, i);
+		}
+
+		return length;
+	}
+
+	bool isValidUtf8(std::string_view str)
+	{
+		std::size_t i = 0;
+
+		while (i < str.size())
+		{
+#ifdef JSONIFY_SSE2
+			if (i + 16 <= str.size() && maskNonAscii(loadChunk(str.data() + i)) == 0)
+			{
+				i += 16;
+				continue;
+			}
+#endif
+			std::size_t length = utf8SequenceLength((const unsigned char*)str.data() + i, str.size() - i);
+			if (length == 0) return false;
+
+			i += length;
+		}
+
+		return true;
+	}
+
+	bool isNumberLiteral(std::string_view str)
+	{
+		std::size_t i = 0;
+
+		auto digits = [&]()
+		{
+			std::size_t start = i;
+			while (i < str.size() && str[i] >= '0' && str[i] <= '9') i++;
+
+			return i > start;
+		};
+
+		if (i < str.size() && str[i] == '-') i++;
+
+		if (i < str.size() && str[i] == '0')
+			i++;
+		else if (!digits())
+			return false;
+
+		if (i < str.size() && str[i] == '.')
+		{
+			i++;
+			if (!digits()) return false;
+		}
+
+		if (i < str.size() && (str[i] == 'e' || str[i] == 'E'))
+		{
+			i++;
+			if (i < str.size() && (str[i] == '+' || str[i] == '-')) i++;
+			if (!digits()) return false;
+		}
+
+		return i == str.size();
+	}
+
+	double numberFromLiteral(std::string_view str)
+	{
+		double res;
+
+		if (std::from_chars(str.data(), str.data() + str.size(), res).ec != std::errc::result_out_of_range) return res;
+
+		//rounded to infinity or zero, as strtod does
+		std::size_t exponent = str.find_first_of("eE");
+
+		bool negative = str[0] == '-';
+		bool tiny = exponent == std::string_view::npos ? str.substr(negative).starts_with('0') : str[exponent + 1] == '-';
+
+		res = tiny ? 0.0 : std::numeric_limits<double>::infinity();
+
+		return negative ? -res : res;
+	}
+
+	std::size_t countNewlines(std::string_view str)
+	{
+		std::size_t count = 0;
+		std::size_t i = 0;
+
+#ifdef JSONIFY_SSE2
+		for (; i + 16 <= str.size(); i += 16)
+		{
+			count += std::popcount(maskEquals(loadChunk(str.data() + i), '\n'));
+		}
+#endif
+		for (; i < str.size(); i++)
+		{
+			if (str[i] == '\n') count++;
+		}
+
+		return count;
+	}
+}
\ No newline at end of file
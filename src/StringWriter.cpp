@@ -1,11 +1,309 @@
 #include "StringWriter.h"
 
-#include <format>
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <vector>
 
-inline void appendIndents(std::string& out, int indents)
+#include "Grammar.h"
+#include "Lexer.h"
+#include "StringUtils.h"
+
+namespace
+{
+	//counts bytes for the measuring pass
+	struct SizeSink
+	{
+		std::size_t size = 0;
+
+		void append(const char*, std::size_t length)
+		{
+			size += length;
+		}
+
+		void appendEscaped(std::string_view str)
+		{
+			size += Jsonify::escapedLength(str);
+		}
+	};
+
+	//stores into a buffer that was sized by a SizeSink
+	struct PointerSink
+	{
+		char* pointer;
+
+		void append(const char* str, std::size_t length)
+		{
+			std::memcpy(pointer, str, length);
+			pointer += length;
+		}
+
+		void appendEscaped(std::string_view str)
+		{
+			pointer = Jsonify::escapeString(str, pointer);
+		}
+	};
+
+	//grows a string as it goes, for when the size is not known up front
+	struct StringSink
+	{
+		std::string& out;
+
+		void append(const char* str, std::size_t length)
+		{
+			out.append(str, length);
+		}
+
+		void appendEscaped(std::string_view str)
+		{
+			Jsonify::escapeString(str, out);
+		}
+	};
+
+	//XXH64 with a seed of 0, fed in pieces of any size
+	class HashSink
+	{
+	public:
+		void append(const char* str, std::size_t length)
+		{
+			total += length;
+
+			if (buffered > 0)
+			{
+				std::size_t taken = std::min(length, sizeof(buffer) - buffered);
+
+				std::memcpy(buffer + buffered, str, taken);
+				buffered += taken;
+				str += taken;
+				length -= taken;
+
+				if (buffered < sizeof(buffer)) return;
+
+				consume(buffer);
+				buffered = 0;
+			}
+
+			for (; length >= sizeof(buffer); str += sizeof(buffer), length -= sizeof(buffer))
+				consume(str);
+
+			std::memcpy(buffer, str, length);
+			buffered = length;
+		}
+
+		//escaped a slice at a time into a buffer on the stack, every byte escapes on its own so slices can split anywhere
+		void appendEscaped(std::string_view str)
+		{
+			constexpr std::size_t slice = 256;
+			char escaped[slice * 6];
+
+			for (std::size_t i = 0; i < str.size(); i += slice)
+			{
+				char* end = Jsonify::escapeString(str.substr(i, slice), escaped);
+				append(escaped, end - escaped);
+			}
+		}
+
+		std::uint64_t digest() const
+		{
+			std::uint64_t h;
+
+			if (total >= sizeof(buffer))
+			{
+				h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+
+				for (std::uint64_t lane : lanes)
+					h = (h ^ round(0, lane)) * prime1 + prime4;
+			}
+			else
+			{
+				h = prime5;
+			}
+
+			h += total;
+
+			std::size_t i = 0;
+
+			for (; i + 8 <= buffered; i += 8)
+				h = std::rotl(h ^ round(0, read<std::uint64_t>(buffer + i)), 27) * prime1 + prime4;
+
+			if (i + 4 <= buffered)
+			{
+				h = std::rotl(h ^ read<std::uint32_t>(buffer + i) * prime1, 23) * prime2 + prime3;
+				i += 4;
+			}
+
+			for (; i < buffered; i++)
+				h = std::rotl(h ^ (unsigned char)buffer[i] * prime5, 11) * prime1;
+
+			h ^= h >> 33;
+			h *= prime2;
+			h ^= h >> 29;
+			h *= prime3;
+			h ^= h >> 32;
+
+			return h;
+		}
+
+	private:
+		static constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87;
+		static constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+		static constexpr std::uint64_t prime3 = 0x165667B19E3779F9;
+		static constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63;
+		static constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5;
+
+		template<typename T>
+		static T read(const char* p)
+		{
+			T value = 0;
+
+			//XXH64 reads little endian, which is a plain load on most targets
+			if constexpr (std::endian::native == std::endian::little)
+			{
+				std::memcpy(&value, p, sizeof(T));
+			}
+			else
+			{
+				for (std::size_t i = 0; i < sizeof(T); i++)
+					value |= (T)(unsigned char)p[i] << (i * 8);
+			}
+
+			return value;
+		}
+
+		static std::uint64_t round(std::uint64_t lane, std::uint64_t input)
+		{
+			return std::rotl(lane + input * prime2, 31) * prime1;
+		}
+
+		void consume(const char* block)
+		{
+			for (std::size_t i = 0; i < 4; i++)
+				lanes[i] = round(lanes[i], read<std::uint64_t>(block + i * 8));
+		}
+
+		std::uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+		char buffer[32];
+		std::size_t buffered = 0;
+		std::uint64_t total = 0;
+	};
+}
+
+template<typename Sink>
+inline void append(Sink& sink, std::string_view str)
+{
+	sink.append(str.data(), str.size());
+}
+
+//shortest round trip form, same as std::format("{}")
+template<typename Sink>
+inline void appendNumber(Sink& sink, double n)
+{
+	char buffer[32];
+	char* end = std::to_chars(buffer, buffer + sizeof(buffer), n).ptr;
+
+	sink.append(buffer, end - buffer);
+}
+
+//ECMAScript Number::toString, which RFC 8785 uses: the same shortest digits, placed without an exponent from 1e-6 up to 1e21
+template<typename Sink>
+inline void appendCanonicalNumber(Sink& sink, double n)
+{
+	if (!std::isfinite(n))
+		throw std::runtime_error("Canonical json has no form for NaN or infinity");
+
+	//also covers -0
+	if (n == 0)
+	{
+		append(sink, "0");
+		return;
+	}
+
+	char buffer[32];
+	char* end = std::to_chars(buffer, buffer + sizeof(buffer), n, std::chars_format::scientific).ptr;
+	char* p = buffer;
+
+	char out[48];
+	char* o = out;
+
+	if (*p == '-')
+	{
+		*o++ = '-';
+		p++;
+	}
+
+	char digits[20];
+	int count = 0;
+
+	for (; *p != 'e'; p++)
+		if (*p != '.') digits[count++] = *p;
+
+	bool negativeExponent = p[1] == '-';
+	int exponent = 0;
+	std::from_chars(p + 2, end, exponent);
+
+	//position of the decimal point relative to the first digit
+	int point = (negativeExponent ? -exponent : exponent) + 1;
+
+	if (count <= point && point <= 21)
+	{
+		o = std::copy(digits, digits + count, o);
+		o = std::fill_n(o, point - count, '0');
+	}
+	else if (0 < point && point <= 21)
+	{
+		o = std::copy(digits, digits + point, o);
+		*o++ = '.';
+		o = std::copy(digits + point, digits + count, o);
+	}
+	else if (-6 < point && point <= 0)
+	{
+		o = std::copy_n("0.", 2, o);
+		o = std::fill_n(o, -point, '0');
+		o = std::copy(digits, digits + count, o);
+	}
+	else
+	{
+		*o++ = digits[0];
+
+		if (count > 1)
+		{
+			*o++ = '.';
+			o = std::copy(digits + 1, digits + count, o);
+		}
+
+		*o++ = 'e';
+		*o++ = point > 0 ? '+' : '-';
+		o = std::to_chars(o, out + sizeof(out), point > 0 ? point - 1 : 1 - point).ptr;
+	}
+
+	sink.append(out, o - out);
+}
+
+//orders keys by UTF-16 code units as RFC 8785 asks, without converting them
+//UTF-8 bytes already order by code point, which only differs where a character from U+E000 to U+FFFF meets one above U+FFFF, whose surrogates sort lower
+inline bool lessUtf16(std::string_view a, std::string_view b)
+{
+	auto [x, y] = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+
+	if (x == a.end() || y == b.end())
+		return a.size() < b.size();
+
+	unsigned char first = *x;
+	unsigned char second = *y;
+
+	if (first >= 0xF0 && second >= 0xEE && second < 0xF0) return true;
+	if (second >= 0xF0 && first >= 0xEE && first < 0xF0) return false;
+
+	return first < second;
+}
+
+template<typename Sink>
+inline void appendIndents(Sink& sink, int indents, std::string_view indent)
 {
 	for (int i = 0; i < indents; i++)
-		out.append("   ");
+		append(sink, indent);
 };
 
 namespace Jsonify
@@ -15,97 +313,429 @@ namespace Jsonify
 	{
 	}
 
-	void StringWriter::write(JsonValue& value, std::string& out)
+	void StringWriter::write(const JsonValue& value, std::string& out) const
+	{
+		//sorting keys costs more than growing the string, so canonical output is written in one pass
+		if (settings.canonical)
+		{
+			StringSink sink = { out };
+			write(value, sink);
+
+			return;
+		}
+
+		std::size_t offset = out.size();
+
+		out.resize(offset + measure(value));
+		write(value, out.data() + offset);
+	}
+
+	std::size_t StringWriter::measure(const JsonValue& value) const
 	{
-		write(value, out, 0);
+		SizeSink sink;
+		write(value, sink);
+
+		return sink.size;
 	}
 
-	void StringWriter::write(JsonValue& value, std::string& out, int indents)
+	char* StringWriter::write(const JsonValue& value, char* out) const
 	{
-		switch (value.type)
+		PointerSink sink = { out };
+		write(value, sink);
+
+		return sink.pointer;
+	}
+
+	std::uint64_t StringWriter::hash(const JsonValue& value) const
+	{
+		HashSink sink;
+		write(value, sink);
+
+		return sink.digest();
+	}
+
+	void StringWriter::transcode(std::string_view in, std::string& out) const
+	{
+		ParseError error;
+
+		if (!tryTranscode(in, out, error))
+			throw std::runtime_error(error.message());
+	}
+
+	bool StringWriter::tryTranscode(std::string_view in, std::string& out, ParseError& error) const
+	{
+		std::size_t offset = out.size();
+		out.reserve(offset + in.size());
+
+		Lexer lexer(in);
+		lexer.nextToken();
+
+		bool transcoded = transcode(lexer, out, error);
+
+		if (transcoded && !lexer.isEnd())
+			transcoded = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
+
+		if (!transcoded)
 		{
-		case JsonValue::Type::Dictionary:
+			out.resize(offset);
+			error.locate(in);
+
+			return false;
+		}
+
+		error = ParseError();
+
+		return true;
+	}
+
+	//same layout as write, only the containers that are open are kept
+	bool StringWriter::transcode(Lexer& lexer, std::string& out, ParseError& error) const
+	{
+		struct Frame
+		{
+			bool isArray;
+			int indents;
+			std::size_t count;
+		};
+
+		//writes the values as the walk reports them
+		struct Transcoder
 		{
-			out.append("{");
-			if (settings.pretty)
-				out.append("\n");
+			const Settings& settings;
+			StringSink sink;
+
+			std::vector<Frame> stack;
+			std::string unescaped;
+			int indents;
 
-			int i = 0;
-			for (auto& [k, v] : value)
+			//elements after the first are separated, a dictionary separates its members at their keys
+			void nextElement()
 			{
-				if (settings.pretty) appendIndents(out, indents + 1);
+				if (stack.empty() || !stack.back().isArray) return;
 
-				out.append("\"");
-				out.append(k);
-				out.append("\"");
+				Frame& frame = stack.back();
 
-				if (settings.pretty)
-					out.append(" : ");
+				if (frame.count++ > 0)
+				{
+					append(sink, ",");
+					if (settings.pretty) append(sink, " ");
+				}
+
+				indents = frame.indents;
+			}
+
+			bool writeString(const Token& tok, ParseError& error)
+			{
+				append(sink, "\"");
+
+				if (settings.normalize)
+				{
+					unescaped.clear();
+
+					if (!unescapeString(tok.rawValue, unescaped))
+						return error.fail(ParseError::Kind::MalformedString, tok);
+
+					sink.appendEscaped(unescaped);
+				}
 				else
-					out.append(":");
+				{
+					if (!validateString(tok.rawValue))
+						return error.fail(ParseError::Kind::MalformedString, tok);
+
+					append(sink, tok.rawValue);
+				}
+
+				append(sink, "\"");
+
+				return true;
+			}
 
-				write(v, out, indents + 1);
+			bool scalar(const Token& tok, ParseError& error)
+			{
+				nextElement();
+
+				switch (tok.type)
+				{
+				case Token::Type::String:
+					return writeString(tok, error);
 
-				if (++i < value.size())
+				case Token::Type::Number:
 				{
-					out.append(",");
+					double num;
+
+					if (!toNumber(tok, num, error)) return false;
+
+					if (settings.normalize)
+						appendNumber(sink, num);
+					else
+						append(sink, tok.rawValue);
+
+					return true;
+				}
+
+				default:
+					append(sink, tok.rawValue);
 
-					if (settings.pretty) out.append("\n");
+					return true;
 				}
 			}
 
-			if (settings.pretty)
+			bool key(const Token& tok, ParseError& error)
 			{
-				out.append("\n");
-				appendIndents(out, indents);
+				Frame& frame = stack.back();
+
+				if (frame.count++ > 0)
+				{
+					append(sink, ",");
+					if (settings.pretty) append(sink, "\n");
+				}
+
+				if (settings.pretty) appendIndents(sink, frame.indents + 1, settings.indent);
+
+				if (!writeString(tok, error)) return false;
+
+				if (settings.pretty)
+					append(sink, " : ");
+				else
+					append(sink, ":");
+
+				indents = frame.indents + 1;
+
+				return true;
 			}
 
-			out.append("}");
+			bool beginContainer(bool isArray, const Token&, ParseError&)
+			{
+				nextElement();
 
-			break;
-		}
+				if (isArray)
+				{
+					append(sink, "[");
+				}
+				else
+				{
+					append(sink, "{");
+					if (settings.pretty)
+						append(sink, "\n");
+				}
 
-		case JsonValue::Type::Array:
-		{
-			out.append("[");
+				stack.push_back({ isArray, indents, 0 });
+
+				return true;
+			}
 
-			for (std::size_t i = 0; i < value.size(); i++)
+			bool endContainer(bool isArray, const Token&, ParseError&)
 			{
-				write(value[i], out, indents);
+				Frame& frame = stack.back();
 
-				if (i < value.size() - 1)
+				if (isArray)
 				{
-					out.append(",");
+					append(sink, "]");
+				}
+				else
+				{
+					if (settings.pretty)
+					{
+						append(sink, "\n");
+						appendIndents(sink, frame.indents, settings.indent);
+					}
 
-					if (settings.pretty) out.append(" ");
+					append(sink, "}");
 				}
+
+				indents = frame.indents;
+				stack.pop_back();
+
+				return true;
 			}
+		};
 
-			out.append("]");
+		Transcoder transcoder = { settings, { out }, {}, {}, 0 };
+		std::vector<bool> open;
 
-			break;
-		}
+		return walkValue(lexer, transcoder, open, settings.maxDepth, error);
+	}
+
+	//walks the tree with an explicit stack so deeply nested values cannot overflow the call stack
+	template<typename Sink>
+	void StringWriter::write(const JsonValue& root, Sink& sink) const
+	{
+		struct Frame
+		{
+			const JsonValue* container;
+			JsonValue::Map::const_iterator next;
+			std::size_t index;
+			int indents;
+
+			//where the sorted members of a canonical dictionary start
+			std::size_t members;
+		};
+
+		std::vector<Frame> stack;
+		const JsonValue* value = &root;
+		int indents = 0;
 
-		case JsonValue::Type::Boolean:
-			out.append(value.b ? "true" : "false");
-			break;
+		bool canonical = settings.canonical;
+		bool pretty = settings.pretty && !canonical;
 
-		case JsonValue::Type::Null:
-			out.append("null");
-			break;
+		//the members of every open canonical dictionary, nested ones after their parents, sorted as pointers so no key is copied
+		std::vector<const JsonValue::Map::value_type*> members;
 
-		case JsonValue::Type::String:
+		auto number = [&](double n)
 		{
-			out.append("\"");
-			out.append(value.s);
-			out.append("\"");
+			if (canonical)
+				appendCanonicalNumber(sink, n);
+			else
+				appendNumber(sink, n);
+		};
 
-			break;
-		}
+		while (true)
+		{
+			switch (value->type)
+			{
+			case JsonValue::Type::Dictionary:
+				append(sink, "{");
+				if (pretty)
+					append(sink, "\n");
+
+				stack.push_back({ value, value->m.begin(), 0, indents, members.size() });
+
+				if (canonical)
+				{
+					for (const auto& member : value->m)
+						members.push_back(&member);
+
+					std::sort(members.begin() + stack.back().members, members.end(), [](const auto* a, const auto* b)
+					{
+						return lessUtf16(a->first, b->first);
+					});
+				}
+				break;
+
+			case JsonValue::Type::Array:
+				append(sink, "[");
+
+				//packed arrays have no nested values, so they are written in one go
+				if (value->packed)
+				{
+					const std::pmr::vector<double>& values = value->p.values;
+
+					for (std::size_t i = 0; i < values.size(); i++)
+					{
+						if (i > 0)
+						{
+							append(sink, ",");
+
+							if (pretty) append(sink, " ");
+						}
+
+						number(values[i]);
+					}
+
+					append(sink, "]");
+					break;
+				}
+
+				stack.push_back({ value, {}, 0, indents, members.size() });
+				break;
+
+			case JsonValue::Type::Boolean:
+				append(sink, value->b ? "true" : "false");
+				break;
+
+			case JsonValue::Type::Null:
+				append(sink, "null");
+				break;
+
+			case JsonValue::Type::String:
+				append(sink, "\"");
+				sink.appendEscaped(value->s);
+				append(sink, "\"");
+				break;
+
+			case JsonValue::Type::Number:
+				if (canonical)
+					number(value->number());
+				else if (value->rawNumber)
+					append(sink, value->s);
+				else
+					appendNumber(sink, value->n);
+				break;
+			}
+
+			//find the next value to write, closing every container that has run out
+			value = nullptr;
+
+			while (!stack.empty() && !value)
+			{
+				Frame& frame = stack.back();
+
+				if (frame.container->type == JsonValue::Type::Array)
+				{
+					const std::pmr::vector<JsonValue>& elements = frame.container->v;
+
+					if (frame.index < elements.size())
+					{
+						if (frame.index > 0)
+						{
+							append(sink, ",");
+
+							if (pretty) append(sink, " ");
+						}
+
+						value = &elements[frame.index++];
+						indents = frame.indents;
+
+						continue;
+					}
+
+					append(sink, "]");
+				}
+				else
+				{
+					if (frame.next != frame.container->m.end())
+					{
+						const JsonValue::Map::value_type& member = canonical ? *members[frame.members + frame.index] : *frame.next;
+
+						if (frame.index++ > 0)
+						{
+							append(sink, ",");
+
+							if (pretty) append(sink, "\n");
+						}
+
+						if (pretty) appendIndents(sink, frame.indents + 1, settings.indent);
+
+						append(sink, "\"");
+						sink.appendEscaped(member.first);
+						append(sink, "\"");
+
+						if (pretty)
+							append(sink, " : ");
+						else
+							append(sink, ":");
+
+						value = &member.second;
+						indents = frame.indents + 1;
+						frame.next++;
+
+						continue;
+					}
+
+					if (pretty)
+					{
+						append(sink, "\n");
+						appendIndents(sink, frame.indents, settings.indent);
+					}
+
+					append(sink, "}");
+					members.resize(frame.members);
+				}
+
+				stack.pop_back();
+			}
 
-		case JsonValue::Type::Number:
-			out.append(std::format("{}", value.n));
-			break;
+			if (!value) return;
 		}
 	}
 }
\ No newline at end of file
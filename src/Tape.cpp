@@ -0,0 +1,347 @@
+#include "Tape.h"
+
+#include <charconv>
+
+#include "Grammar.h"
+#include "Lexer.h"
+#include "StringUtils.h"
+
+namespace Jsonify
+{
+	namespace
+	{
+		//appends entries as the walk reports values
+		struct Builder
+		{
+			std::vector<TapeEntry>& entries;
+
+			//indices of the containers that are still open
+			std::vector<std::uint32_t> open;
+
+			void push(TapeEntry::Type type, const Token& tok, bool escaped)
+			{
+				entries.push_back({ type, escaped, (std::uint32_t)tok.location.start, { (std::uint32_t)tok.rawValue.size() }, 0 });
+			}
+
+			bool pushString(const Token& tok, ParseError& error)
+			{
+				if (!validateString(tok.rawValue)) return error.fail(ParseError::Kind::MalformedString, tok);
+
+				push(TapeEntry::Type::String, tok, tok.rawValue.find('\\') != std::string_view::npos);
+
+				return true;
+			}
+
+			//every value counts toward the container it is in
+			void count()
+			{
+				if (!open.empty()) entries[open.back()].count++;
+			}
+
+			bool scalar(const Token& tok, ParseError& error)
+			{
+				switch (tok.type)
+				{
+				case Token::Type::Null:
+					push(TapeEntry::Type::Null, tok, false);
+					break;
+
+				case Token::Type::Boolean:
+					push(TapeEntry::Type::Boolean, tok, false);
+					break;
+
+				case Token::Type::String:
+					if (!pushString(tok, error)) return false;
+					break;
+
+				default:
+				{
+					double num;
+
+					if (!toNumber(tok, num, error)) return false;
+
+					push(TapeEntry::Type::Number, tok, false);
+					break;
+				}
+				}
+
+				count();
+
+				return true;
+			}
+
+			bool key(const Token& tok, ParseError& error)
+			{
+				return pushString(tok, error);
+			}
+
+			bool beginContainer(bool isArray, const Token& tok, ParseError&)
+			{
+				count();
+
+				open.push_back((std::uint32_t)entries.size());
+				entries.push_back({ isArray ? TapeEntry::Type::ArrayStart : TapeEntry::Type::DictionaryStart, false, (std::uint32_t)tok.location.start, { 0 }, 0 });
+
+				return true;
+			}
+
+			bool endContainer(bool isArray, const Token& tok, ParseError&)
+			{
+				std::uint32_t start = open.back();
+				std::uint32_t end = (std::uint32_t)entries.size();
+
+				entries.push_back({ isArray ? TapeEntry::Type::ArrayEnd : TapeEntry::Type::DictionaryEnd, false, (std::uint32_t)tok.location.start, { 0 }, start });
+				entries[start].link = end;
+
+				open.pop_back();
+
+				return true;
+			}
+		};
+	}
+
+	Tape::Tape()
+		: settings()
+	{
+	}
+
+	Tape::Tape(Settings settings)
+		: settings(settings)
+	{
+	}
+
+	void Tape::build(std::string_view source)
+	{
+		ParseError error;
+
+		if (!tryBuild(source, error))
+			throw std::runtime_error(error.message());
+	}
+
+	bool Tape::tryBuild(std::string_view source, ParseError& error)
+	{
+		entries.clear();
+		this->source = source;
+
+		if (source.size() > UINT32_MAX)
+		{
+			error.kind = ParseError::Kind::TooLarge;
+			error.offset = 0;
+
+			return false;
+		}
+
+		Lexer lexer(source);
+		lexer.nextToken();
+
+		Builder builder = { entries, {} };
+		std::vector<bool> open;
+
+		bool built = walkValue(lexer, builder, open, settings.maxDepth, error);
+
+		if (built && !lexer.isEnd())
+			built = error.fail(ParseError::Kind::TrailingContent, lexer.readToken());
+
+		if (!built)
+		{
+			entries.clear();
+			error.locate(source);
+
+			return false;
+		}
+
+		error = ParseError();
+
+		return true;
+	}
+
+	const std::vector<TapeEntry>& Tape::getEntries() const
+	{
+		return entries;
+	}
+
+	const TapeEntry& Tape::operator[](std::size_t index) const
+	{
+		return entries[index];
+	}
+
+	std::size_t Tape::skip(std::size_t index) const
+	{
+		const TapeEntry& entry = entries[index];
+
+		if (entry.type == TapeEntry::Type::ArrayStart || entry.type == TapeEntry::Type::DictionaryStart)
+			return entry.link + 1;
+
+		return index + 1;
+	}
+
+	std::size_t Tape::size(std::size_t index) const
+	{
+		const TapeEntry& entry = entries[index];
+
+		if (entry.type != TapeEntry::Type::ArrayStart && entry.type != TapeEntry::Type::DictionaryStart)
+			throw std::runtime_error("Unable to get size of a type that is not Dictionary or Array");
+
+		return entry.count;
+	}
+
+	std::size_t Tape::find(std::size_t dictionary, std::string_view key) const
+	{
+		if (entries[dictionary].type != TapeEntry::Type::DictionaryStart) throw std::runtime_error("Type is not a dictionary");
+
+		std::size_t end = entries[dictionary].link;
+
+		for (std::size_t i = dictionary + 1; i < end; i = skip(i + 1))
+		{
+			const TapeEntry& entry = entries[i];
+
+			if (!entry.escaped)
+			{
+				if (getRaw(i) == key) return i + 1;
+
+				continue;
+			}
+
+			if (unescapedEquals(getRaw(i), key)) return i + 1;
+		}
+
+		return npos;
+	}
+
+	std::size_t Tape::at(std::size_t array, std::size_t n) const
+	{
+		if (entries[array].type != TapeEntry::Type::ArrayStart) throw std::runtime_error("Type is not an array");
+		if (n >= entries[array].count) return npos;
+
+		std::size_t i = array + 1;
+		for (std::size_t j = 0; j < n; j++)
+		{
+			i = skip(i);
+		}
+
+		return i;
+	}
+
+	std::string_view Tape::getRaw(std::size_t index) const
+	{
+		const TapeEntry& entry = entries[index];
+
+		return source.substr(entry.offset, entry.length);
+	}
+
+	std::string Tape::getString(std::size_t index) const
+	{
+		if (entries[index].type != TapeEntry::Type::String) throw std::runtime_error("Type mismatch, expected a string");
+
+		if (!entries[index].escaped) return std::string(getRaw(index));
+
+		std::string res;
+		unescapeString(getRaw(index), res);
+
+		return res;
+	}
+
+	double Tape::getNumber(std::size_t index) const
+	{
+		if (entries[index].type != TapeEntry::Type::Number) throw std::runtime_error("Type mismatch, expected a number");
+
+		std::string_view raw = getRaw(index);
+
+		double res = 0;
+		std::from_chars(raw.data(), raw.data() + raw.size(), res);
+
+		return res;
+	}
+
+	bool Tape::getBoolean(std::size_t index) const
+	{
+		if (entries[index].type != TapeEntry::Type::Boolean) throw std::runtime_error("Type mismatch, expected a bool");
+
+		return getRaw(index) == "true";
+	}
+
+	//containers are filled from an explicit stack, so a deep tape cannot overflow the call stack
+	void Tape::toValue(std::size_t index, JsonValue& value) const
+	{
+		struct Frame
+		{
+			JsonValue* container;
+
+			//next child entry, the container ends at end
+			std::size_t child;
+			std::size_t end;
+
+			//next array element to fill
+			std::size_t element;
+		};
+
+		std::vector<Frame> stack;
+		JsonValue* slot = &value;
+
+		while (true)
+		{
+			const TapeEntry& entry = entries[index];
+
+			*slot = JsonValue();
+
+			switch (entry.type)
+			{
+			case TapeEntry::Type::Null:
+				break;
+
+			case TapeEntry::Type::Boolean:
+				*slot = getBoolean(index);
+				break;
+
+			case TapeEntry::Type::Number:
+				*slot = getNumber(index);
+				break;
+
+			case TapeEntry::Type::String:
+				*slot = getString(index);
+				break;
+
+			case TapeEntry::Type::ArrayStart:
+				slot->resize(entry.count);
+				stack.push_back({ slot, index + 1, entry.link, 0 });
+				break;
+
+			case TapeEntry::Type::DictionaryStart:
+				slot->setType(JsonValue::Type::Dictionary);
+				stack.push_back({ slot, index + 1, entry.link, 0 });
+				break;
+
+			default:
+				throw std::runtime_error("Tape index does not start a value");
+			}
+
+			//move on to the next value to fill, closing every container that is done
+			while (true)
+			{
+				if (stack.empty()) return;
+
+				Frame& frame = stack.back();
+
+				if (frame.child == frame.end)
+				{
+					stack.pop_back();
+					continue;
+				}
+
+				if (frame.container->isArray())
+				{
+					index = frame.child;
+					slot = &(*frame.container)[frame.element++];
+				}
+				else
+				{
+					index = frame.child + 1;
+					slot = &(*frame.container)[getString(frame.child)];
+				}
+
+				frame.child = skip(index);
+				break;
+			}
+		}
+	}
+}
\ No newline at end of file